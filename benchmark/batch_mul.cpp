@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <functional>
+#include "alt_bn128.hpp"
+
+using namespace AltBn128;
+
+// Multiplies N different G1 bases by N scalars one by one, converting each product to
+// affine, and with batchMulByScalar.
+// usage: batch_mul_benchmark N
+int main(int argc, char **argv) {
+
+    int64_t N = argc > 1 ? atoll(argv[1]) : 100000;
+
+    uint8_t *scalars = new uint8_t[N*32];
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int64_t i=0; i<N*4; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        *(uint64_t *)(scalars + i*8) = seed;
+    }
+    G1Point *points = new G1Point[N];
+    G1PointAffine *bases = new G1PointAffine[N];
+    G1PointAffine *r = new G1PointAffine[N];
+    G1.copy(points[0], G1.one());
+    for (int64_t i=1; i<N; i++) G1.add(points[i], points[i-1], G1.one());
+    G1.batchToAffine(bases, points, N);
+
+    auto run = [&](const char *name, std::function<void()> f) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double secs = std::chrono::duration<double>(t1 - t0).count();
+        printf("%-18s %8.4fs %8.2fus per point\n", name, secs, secs * 1e6 / N);
+    };
+
+    run("mulByScalar", [&]() {
+        #pragma omp parallel for
+        for (int64_t i=0; i<N; i++) {
+            G1Point p;
+            G1.mulByScalar(p, bases[i], scalars + i*32, 32);
+            G1.copy(r[i], p);
+        }
+    });
+    run("batchMulByScalar", [&]() { G1.batchMulByScalar(r, bases, scalars, 32, N); });
+
+    delete[] points;
+    delete[] bases;
+    delete[] r;
+    delete[] scalars;
+}
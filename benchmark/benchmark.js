@@ -7,17 +7,22 @@ const exec = util.promisify(require("child_process").exec);
 const buildZqField = require("../index.js").buildZqField;
 const bigInt = require("big-integer");
 const N = 1000000000;
+const NL = 100000000;
+const NI = 1000000;
+const NS = 10000000;
 
-async function benchmarkMM(op, prime) {
+// Builds benchmark/<op>.cpp with the field of the prime and returns the temporary dir.
+// nr adds the kernels of the quadratic extension.
+async function buildBenchmark(op, prime, karatsuba, special, flags, nr) {
     const dir = await tmp.dir({prefix: "circom_", unsafeCleanup: true });
     
-    const source = await buildZqField(prime, "Fr");
+    const source = await buildZqField(prime, "Fr", "asm", karatsuba, special, nr);
 
     // console.log(dir.path);
 
     await fs.promises.writeFile(path.join(dir.path, "fr.asm"), source.asm, "utf8");
-    await fs.promises.writeFile(path.join(dir.path, "fr.hpp"), source.h, "utf8");
-    await fs.promises.writeFile(path.join(dir.path, "fr.cpp"), source.c, "utf8");
+    await fs.promises.writeFile(path.join(dir.path, "fr.hpp"), source.hpp, "utf8");
+    await fs.promises.writeFile(path.join(dir.path, "fr.cpp"), source.cpp, "utf8");
 
     await exec(`cp  ${path.join(__dirname,  `${op}.cpp`)} ${dir.path}`);
 
@@ -36,18 +41,79 @@ async function benchmarkMM(op, prime) {
        ` ${path.join(dir.path,  "fr.o")}` +
        ` ${path.join(dir.path,  "fr.cpp")}` +
        ` -o ${path.join(dir.path, "benchmark")}` +
-       " -lgmp -O3"
+       " -lgmp -O3" + (flags || "")
     );
 
+    return dir;
+}
+
+async function benchmarkMM(op, prime, karatsuba, n, special) {
+    const dir = await buildBenchmark(op, prime, karatsuba, special);
+    n = n || N;
+
     const t1 = performance.now();
 
-    await exec(`${path.join(dir.path,  "benchmark")} ${N}`);
+    await exec(`${path.join(dir.path,  "benchmark")} ${n}`);
 
     const t2 = performance.now();
 
     return t2-t1;
 }
 
+// Largest prime below 2^(64*n64 - 2), so every limb count is tested with a full size prime.
+function primeForLimbs(n64) {
+    let p = bigInt.one.shiftLeft(64*n64 - 2).minus(1);
+    while (!p.isProbablePrime(32)) p = p.minus(2);
+    return p;
+}
+
+// Reports ns per multiplication for each limb count with CIOS and with Karatsuba,
+// to find the n64 from which --karatsuba pays off in this machine.
+async function benchmarkLimbs() {
+    for (let n64=4; n64<=12; n64++) {
+        const q = primeForLimbs(n64);
+        for (const op of ["rawmmul", "rawsquare"]) {
+            const tc = await benchmarkMM(op, q, 0, NL);
+            const tk = await benchmarkMM(op, q, 2, NL);
+            console.log(`${op} n64=${n64}: CIOS ${(tc * 1e6 / NL).toFixed(2)}ns Karatsuba ${(tk * 1e6 / NL).toFixed(2)}ns per multiplication.`);
+        }
+    }
+}
+
+// Element-wise kernels of c/vecops.hpp over arrays larger than the caches. The program
+// prints the ns per element and the memory bandwidth of each kernel.
+async function benchmarkVecOps(n) {
+    const dir = await buildBenchmark("vecops", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"),
+        undefined, undefined, ` -I ${path.join(__dirname, "..", "c")} -fopenmp`);
+    const res = await exec(`${path.join(dir.path,  "benchmark")} ${n}`);
+    process.stdout.write(res.stdout);
+}
+
+// Fq2 products of bn128 with the kernels generated with --nr=-1 and with the field
+// operations
+async function benchmarkF2(n) {
+    const dir = await buildBenchmark("f2mul", bigInt("21888242871839275222246405745257275088696311157297823662689037894645226208583"),
+        undefined, undefined, ` -I ${path.join(__dirname, "..", "c")} ${path.join(__dirname, "..", "c", "splitparstr.cpp")}`, -1);
+    const res = await exec(`${path.join(dir.path,  "benchmark")} ${n}`);
+    process.stdout.write(res.stdout);
+}
+
+// Special form primes with their own reduction and with Montgomery
+async function benchmarkSpecial() {
+    const primes = {
+        "goldilocks": bigInt("18446744069414584321"),
+        "secp256k1": bigInt("115792089237316195423570985008687907853269984665640564039457584007908834671663"),
+        "2^255-19": bigInt("57896044618658097711785492504343953926634992332820282019728792003956564819949")
+    };
+    for (const name of Object.keys(primes)) {
+        for (const op of ["rawmmul", "rawmmulvec"]) {
+            const ts = await benchmarkMM(op, primes[name], undefined, NL);
+            const tm = await benchmarkMM(op, primes[name], undefined, NL, false);
+            console.log(`${op} ${name}: special ${(ts * 1e6 / NL).toFixed(2)}ns Montgomery ${(tm * 1e6 / NL).toFixed(2)}ns per multiplication.`);
+        }
+    }
+}
+
 async function run() {
     let t;
 /*
@@ -112,6 +178,13 @@ async function run() {
     // console.log("Raw multiplication mnt6753 Montgomery IntelASM: " + (t/1000) + "s " + (t * 1e6 / N) + "ns per multiplication.");
 
 
+    t = await benchmarkMM("rawmmulvec", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"));
+    console.log("Raw vector multiplication bn256r Montgomery IntelASM: " + (t/1000) + "s " + (t * 1e6 / N) + "ns per multiplication.");
+
+    t = await benchmarkMM("rawmmulvec", bigInt("4002409555221667393417789825735904156556882819939007885332058136124031650490837864442687629129015664037894272559787"));
+    console.log("Raw vector multiplication bls12-381 Montgomery IntelASM: " + (t/1000) + "s " + (t * 1e6 / N) + "ns per multiplication.");
+
+
     //  SQUARE
     t = await benchmarkMM("square", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"));
     console.log("Square bn256r Montgomery IntelASM: " + (t/1000) + "s " + (t * 1e6 / N) + "ns per multiplication.");
@@ -131,7 +204,41 @@ async function run() {
     // t = await benchmarkMM("rawsquare", bigInt("41898490967918953402344214791240637128170709919953949071783502921025352812571106773058893763790338921418070971888253786114353726529584385201591605722013126468931404347949840543007986327743462853720628051692141265303114721689601"));
     // console.log("Raw square mnt6753 Montgomery IntelASM: " + (t/1000) + "s " + (t * 1e6 / N) + "ns per multiplication.");
 
+    //  INVERSE
+    t = await benchmarkMM("inv", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"), undefined, NI);
+    console.log("Inverse bn256r binary GCD: " + (t/1000) + "s " + (t * 1e6 / NI) + "ns per inverse.");
+
+    t = await benchmarkMM("mpzinv", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"), undefined, NI);
+    console.log("Inverse bn256r GMP: " + (t/1000) + "s " + (t * 1e6 / NI) + "ns per inverse.");
+
+    t = await benchmarkMM("inv", bigInt("4002409555221667393417789825735904156556882819939007885332058136124031650490837864442687629129015664037894272559787"), undefined, NI);
+    console.log("Inverse bls12-381 binary GCD: " + (t/1000) + "s " + (t * 1e6 / NI) + "ns per inverse.");
+
+    t = await benchmarkMM("mpzinv", bigInt("4002409555221667393417789825735904156556882819939007885332058136124031650490837864442687629129015664037894272559787"), undefined, NI);
+    console.log("Inverse bls12-381 GMP: " + (t/1000) + "s " + (t * 1e6 / NI) + "ns per inverse.");
+
+    //  SERIALIZATION
+    t = await benchmarkMM("rpr", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"), undefined, NL);
+    console.log("Bytes round trip bn256r array conversions: " + (t/1000) + "s " + (t * 1e6 / NL) + "ns per element.");
+
+    t = await benchmarkMM("rprmpz", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"), undefined, NL);
+    console.log("Bytes round trip bn256r GMP: " + (t/1000) + "s " + (t * 1e6 / NL) + "ns per element.");
+
+    t = await benchmarkMM("str", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"), undefined, NS);
+    console.log("Decimal string round trip bn256r: " + (t/1000) + "s " + (t * 1e6 / NS) + "ns per element.");
+
+    t = await benchmarkMM("strmpz", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"), undefined, NS);
+    console.log("Decimal string round trip bn256r GMP: " + (t/1000) + "s " + (t * 1e6 / NS) + "ns per element.");
+
+    //  VECTOR KERNELS
+    await benchmarkVecOps(NS);
+
+    //  QUADRATIC EXTENSION
+    await benchmarkF2(NL);
+
+    await benchmarkSpecial();
 
+    await benchmarkLimbs();
 }
 
 run();
@@ -464,13 +464,13 @@ void CurveAdds::calculateMultiSums ( void )
     printf("\nStarting %'ld multi sums ....\n", n);
     #ifdef FFIASM_FR_COUNTERS
     F1Element k;
-    RawFq::Stats stats = G1.F.stats;
+    RawFq::Stats stats = G1.F.getStats();
     #endif
     start = clock();
     G1.multiAdd(multiSums, affineBases, affineBases + n, n);
     end = clock();
     #ifdef FFIASM_FR_COUNTERS
-    RawFq::Stats stats2 = G1.F.stats;
+    RawFq::Stats stats2 = G1.F.getStats();
     printf("cntAdd:%'ld\n",  stats2.cntAdd-stats.cntAdd);
     printf("cntSub:%'ld\n",  stats2.cntSub-stats.cntSub);
     printf("cntMMul:%'ld\n", stats2.cntMMul-stats.cntMMul);
@@ -522,7 +522,7 @@ void CurveAdds::calculateSums ( void )
     printf("\nStarting %'ld sums ....\n", n);
     #ifdef FFIASM_FR_COUNTERS
     F1Element k;
-    RawFq::Stats stats = G1.F.stats;
+    RawFq::Stats stats = G1.F.getStats();
     #endif
 
     auto startUs = getRealTimeClockUs();
@@ -534,7 +534,7 @@ void CurveAdds::calculateSums ( void )
     end = clock();
     auto endUs = getRealTimeClockUs();    
     #ifdef FFIASM_FR_COUNTERS
-    RawFq::Stats stats2 = G1.F.stats;
+    RawFq::Stats stats2 = G1.F.getStats();
     printf("cntAdd:%'ld\n",  stats2.cntAdd-stats.cntAdd);
     printf("cntSub:%'ld\n",  stats2.cntSub-stats.cntSub);
     printf("cntMMul:%'ld\n", stats2.cntMMul-stats.cntMMul);
@@ -565,7 +565,7 @@ void CurveAdds::calculateBaseOperations ( void )
 
     #ifdef FFIASM_FR_COUNTERS
     F1Element k;
-    RawFq::Stats stats = G1.F.stats;
+    RawFq::Stats stats = G1.F.getStats();
     #endif
     #define R_IND (8192 + (i & 0x001))
     #define R_OP1 (8192 + (i & 0x001))
@@ -644,7 +644,7 @@ void CurveAdds::calculateBaseOperations ( void )
         }
         end[timerIndex++] = clock();
         #ifdef FFIASM_FR_COUNTERS
-        RawFq::Stats stats2 = G1.F.stats;
+        RawFq::Stats stats2 = G1.F.getStats();
         printf("cntAdd:%'ld\n",  stats2.cntAdd-stats.cntAdd);
         printf("cntSub:%'ld\n",  stats2.cntSub-stats.cntSub);
         printf("cntMMul:%'ld\n", stats2.cntMMul-stats.cntMMul);
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include "fr.hpp"
+#include "f2field.hpp"
+
+// Fq2 products by nr = -1 with the fused kernels of the field and with the separate
+// field operations that F2Field uses without them. Prints the time per product.
+int main(int argc, char **argv) {
+
+    int64_t N = atoll(argv[1]);
+
+    F2Field<RawFr> F2("-1");
+    RawFr &F = F2.F;
+    F2Field<RawFr>::Element a, b;
+    F2.fromString(a, "(12345678901234567890,98765432109876543210)");
+    F2.square(b, a);
+
+    auto run = [&](const char *name, std::function<void()> op) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int64_t i=0; i<N; i++) op();
+        auto t1 = std::chrono::steady_clock::now();
+        printf("%-20s %6.2fns\n", name, std::chrono::duration<double>(t1 - t0).count() * 1e9 / N);
+    };
+
+    run("mul", [&]() { F2.mul(a, a, b); });
+    run("mul separate", [&]() {
+        RawFr::Element t;
+        F.mulSubMul(t, a.a, b.a, a.b, b.b);
+        F.mulAddMul(a.b, a.a, b.b, a.b, b.a);
+        F.copy(a.a, t);
+    });
+    run("square", [&]() { F2.square(a, a); });
+    run("square separate", [&]() {
+        RawFr::Element s, d, ab;
+        F.mul(ab, a.a, a.b);
+        F.add(s, a.a, a.b);
+        F.sub(d, a.a, a.b);
+        F.mul(a.a, s, d);
+        F.add(a.b, ab, ab);
+    });
+
+    printf("%s\n", F2.toString(a).c_str());
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <functional>
+#include "alt_bn128.hpp"
+#include "fixed_base_table.hpp"
+
+using namespace AltBn128;
+
+// Multiplies the generator of G1 by N random scalars with nafMulByScalar, with the
+// precomputed table one by one and with mulMany, which also converts to affine.
+// usage: fixed_base_benchmark N [windowBits]
+int main(int argc, char **argv) {
+
+    int64_t N = argc > 1 ? atoll(argv[1]) : 100000;
+    uint32_t w = argc > 2 ? atoi(argv[2]) : 8;
+
+    uint8_t *scalars = new uint8_t[N*32];
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int64_t i=0; i<N*4; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        *(uint64_t *)(scalars + i*8) = seed;
+    }
+    G1PointAffine *r = new G1PointAffine[N];
+    G1Point p;
+
+    auto run = [&](const char *name, int64_t count, std::function<void()> f) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double secs = std::chrono::duration<double>(t1 - t0).count();
+        printf("%-16s %8.4fs %8.2fus per point\n", name, secs, secs * 1e6 / count);
+    };
+
+    printf("window: %u bits, table: %lu bytes\n", w, FixedBaseTable<Curve<RawFq>>::tableSize(32, w));
+    FixedBaseTable<Curve<RawFq>> *t;
+    run("table", (32*8/w + 1) << (w-1), [&]() { t = new FixedBaseTable<Curve<RawFq>>(G1, G1.oneAffine(), 32, w); });
+    run("mulByScalar", N, [&]() {
+        for (int64_t i=0; i<N; i++) {
+            G1.mulByScalar(p, G1.one(), scalars + i*32, 32);
+            G1.copy(r[i], p);
+        }
+    });
+    run("table mul", N, [&]() {
+        for (int64_t i=0; i<N; i++) {
+            t->mul(p, scalars + i*32);
+            G1.copy(r[i], p);
+        }
+    });
+    run("table mulMany", N, [&]() { t->mulMany(r, scalars, N); });
+
+    delete t;
+    delete[] r;
+    delete[] scalars;
+}
@@ -0,0 +1,18 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "fr.hpp"
+
+int main(int argc, char **argv) {
+
+    int N = atoi(argv[1]);
+
+    RawFr F;
+
+    RawFr::Element a;
+    F.fromString(a, "99999999999");
+    
+    for (int i=0; i<N; i++) {
+        F.inv(a, a);
+        F.add(a, a, F.one());
+    }
+}
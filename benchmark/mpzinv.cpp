@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "fr.hpp"
+
+// Inversion through GMP, as RawFr::inv did before the binary GCD
+void mpzInv(RawFr::Element &r, const RawFr::Element &a, mpz_t q) {
+    mpz_t mr;
+    mpz_init(mr);
+    mpz_import(mr, Fr_N64, -1, 8, -1, 0, (const void *)(a.v));
+    mpz_invert(mr, mr, q);
+    for (int i=0; i<Fr_N64; i++) r.v[i] = 0;
+    mpz_export((void *)(r.v), NULL, -1, 8, -1, 0, mr);
+    Fr_rawMMul(r.v, r.v, Fr_rawR3);
+    mpz_clear(mr);
+}
+
+int main(int argc, char **argv) {
+
+    int N = atoi(argv[1]);
+
+    RawFr F;
+    mpz_t q;
+    mpz_init(q);
+    mpz_import(q, Fr_N64, -1, 8, -1, 0, (const void *)Fr_rawq);
+
+    RawFr::Element a;
+    F.fromString(a, "99999999999");
+    
+    for (int i=0; i<N; i++) {
+        mpzInv(a, a, q);
+        F.add(a, a, F.one());
+    }
+
+    mpz_clear(q);
+}
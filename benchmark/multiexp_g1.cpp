@@ -33,14 +33,15 @@ class MultiExpG1
         int loop;
         int64_t n;
         int times;
-        const int modes = 2;
+        const int modes = 4;
         bool flgSaveDataFile;
         bool flgLoadDataFile;
         bool flgOriginalMode;
         bool flgMultiMode;
+        bool flgGlvMode;
         std::string dataFilename;
-        double cpuTime [2];
-        double realTime [2];
+        double cpuTime [4];
+        double realTime [4];
         uint8_t *scalars;
         G1PointAffine *bases;
 
@@ -93,29 +94,33 @@ void MultiExpG1::createDataFile ( const std::string &filename, int64_t _n )
         count -= cblock;
     }
 
-    G1PointAffine *bases = new G1PointAffine[block+2];
+    G1Point *points = new G1Point[block+2];
+    G1PointAffine *bases = new G1PointAffine[block];
 
-    G1.copy(bases[0], G1.one());
-    G1.copy(bases[1], G1.one());
+    G1.copy(points[0], G1.one());
+    G1.copy(points[1], G1.one());
     
 
     count = n;
     while (count > 0) {
         int64_t cblock = count > block ? block : count;
         for (int i=2; i<(cblock + 2); i++) {
-            G1.add(bases[i], bases[i-1], bases[i-2]);
+            G1.add(points[i], points[i-1], points[i-2]);
         }
+        G1.batchToAffine(bases, points, cblock);
         bytes = cblock * sizeof(bases[0]);
         bytesWritten = write(fd, bases, bytes);
         if (bytes != bytesWritten) {
             printf("ERROR writting %ld bytes (bases), write only %ld bytes. E:%d %s\n", bytes, bytesWritten, errno, strerror(errno));
             exit(EXIT_FAILURE);
         }
-        G1.copy(bases[0], bases[cblock]);
-        G1.copy(bases[1], bases[cblock+1]);
+        G1.copy(points[0], points[cblock]);
+        G1.copy(points[1], points[cblock+1]);
     
         count -= cblock;
     }
+    delete[] points;
+    delete[] bases;
 
     close(fd);
 }
@@ -224,13 +229,22 @@ void MultiExpG1::executeBenchmark ( int mode )
         case 1:
             G1.multiMulByScalarBa(p1, bases, (uint8_t *)scalars, nscalars, n);
             break;
+
+        case 2:
+            G1Glv.multiMulByScalar(p1, bases, (uint8_t *)scalars, nscalars, n);
+            break;
+
+        case 3:
+            G1Glv.multiMulByScalarBa(p1, bases, (uint8_t *)scalars, nscalars, n);
+            break;
     }
     end = clock();
     endT = getRealTimeClockUs();
     #ifdef COUNT_OPS
-    printf("AddM: %'d | Add: %'d | AddA: %'d | AddT: %'d | Dbl: %'d | DblM: %'d | DblT: %'d | Eq: %'d | EqM: %'d | ToA: %'d\n",
-        G1.cntAddMixed, G1.cntAdd, G1.cntAddAffine, G1.cntAddMixed + G1.cntAdd + G1.cntAddAffine,
-        G1.cntDbl, G1.cntDblMixed, G1.cntDbl + G1.cntDblMixed, G1.cntEq, G1.cntEqMixed, G1.cntToAffine);
+    auto cnt = G1.getCounters();
+    printf("AddM: %'lu | Add: %'lu | AddA: %'lu | AddT: %'lu | Dbl: %'lu | DblM: %'lu | DblT: %'lu | Eq: %'lu | EqM: %'lu | ToA: %'lu\n",
+        cnt.cntAddMixed, cnt.cntAdd, cnt.cntAddAffine, cnt.cntAddMixed + cnt.cntAdd + cnt.cntAddAffine,
+        cnt.cntDbl, cnt.cntDblMixed, cnt.cntDbl + cnt.cntDblMixed, cnt.cntEq, cnt.cntEqMixed, cnt.cntToAffine);
     #endif
 
     cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
@@ -268,6 +282,7 @@ MultiExpG1::MultiExpG1 ( void )
     flgLoadDataFile = true;
     flgOriginalMode = false;
     flgMultiMode = false;
+    flgGlvMode = false;
     dataFilename = "multiexp_test_data_128000000.dat";
 
     setlocale(LC_ALL, "en_US.utf-8");
@@ -287,12 +302,13 @@ void MultiExpG1::help ( const std::string &prgname )
 {
     std::string cmd = prgname.substr(prgname.find_last_of("/\\") + 1);
 
-    printf("usage: %s [-h] [-1] [-2] [-a] [-s <filename>] [-l <filename>] [-n <#points>] [-t <#loops>]\n", cmd.c_str());
+    printf("usage: %s [-h] [-1] [-2] [-a] [-g] [-s <filename>] [-l <filename>] [-n <#points>] [-t <#loops>]\n", cmd.c_str());
     printf(" where:\n");
     printf("  -h show this help.\n");
     printf("  -1 benchmark using one-by-one add.\n");
     printf("  -2 benchmark using batch adds.\n");
     printf("  -a make all benchmarks.\n");
+    printf("  -g also run the selected benchmarks splitting the scalars with the endomorphism.\n");
     printf("  -s <filename> generate a data file <filename> with #points.\n");
     printf("  -l <filename> load data from file <filename>.\n");
     printf("  -n <#points> benchmark with #points, could use M or K suffix.\n");
@@ -303,7 +319,7 @@ void MultiExpG1::parseArguments( int argc, char **argv )
 {
     int opt;
 
-    while ((opt = getopt(argc, argv, "n:t:a12hs:l:")) != -1) {
+    while ((opt = getopt(argc, argv, "n:t:a12ghs:l:")) != -1) {
         switch (opt) {
             case 'n':
             {
@@ -333,6 +349,10 @@ void MultiExpG1::parseArguments( int argc, char **argv )
                 flgOriginalMode = true;
                 break;
 
+            case 'g':
+                flgGlvMode = true;
+                break;
+
             case 'h':
                 help(argv[0]);
                 exit(EXIT_SUCCESS);
@@ -413,6 +433,12 @@ void MultiExpG1::summary ( void )
     if (flgOriginalMode && flgMultiMode) {
         printf("multi vs original real: %0.2lf%%  cpu: %0.2lf%%\n", realTime[1]*100.0/realTime[0], cpuTime[1]*100.0/cpuTime[0]);
     }
+    if (flgGlvMode && flgOriginalMode) {
+        printf("original glv avg(real): %.4lf  avg(cpu): %.4lf seconds (%0.2lf%%)\n", realTime[2]/(double) times, cpuTime[2]/(double)times, realTime[2]*100.0/realTime[0]);
+    }
+    if (flgGlvMode && flgMultiMode) {
+        printf("multiadd glv avg(real): %.4lf  avg(cpu): %.4lf seconds (%0.2lf%%)\n", realTime[3]/(double) times, cpuTime[3]/(double)times, realTime[3]*100.0/realTime[1]);
+    }
 }
 
 void MultiExpG1::executeBenchmarks ( void )
@@ -427,6 +453,16 @@ void MultiExpG1::executeBenchmarks ( void )
             printf("\n====> BENCHMARK (multi-add) %d/%d <====\n\n", loop + 1, times);
             executeBenchmark(1);
         }
+
+        if (flgGlvMode && flgOriginalMode) {
+            printf("\n====> BENCHMARK (normal, glv) %d/%d <====\n\n", loop + 1, times);
+            executeBenchmark(2);
+        }
+
+        if (flgGlvMode && flgMultiMode) {
+            printf("\n====> BENCHMARK (multi-add, glv) %d/%d <====\n\n", loop + 1, times);
+            executeBenchmark(3);
+        }
     }
 }
 
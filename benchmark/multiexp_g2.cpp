@@ -32,27 +32,45 @@ int main(int argc, char **argv) {
         *((uint64_t *)(scalars + i*8)) = lehmer64();
     }
 
-    G2.copy(bases[0], G2.one());
-    G2.copy(bases[1], G2.one());
-
-    for (int i=2; i<N; i++) {
-        G2.add(bases[i], bases[i-1], bases[i-2]);
+    // In blocks, converted to affine with one inversion per block
+    const int block = 10240;
+    G2Point *points = new G2Point[block+2];
+    G2.copy(points[0], G2.one());
+    G2.copy(points[1], G2.one());
+    for (int i=0; i<N; i+=block) {
+        int cblock = N-i > block ? block : N-i;
+        for (int j=2; j<cblock+2; j++) {
+            G2.add(points[j], points[j-1], points[j-2]);
+        }
+        G2.batchToAffine(bases + i, points, cblock);
+        G2.copy(points[0], points[cblock]);
+        G2.copy(points[1], points[cblock+1]);
     }
+    delete[] points;
 
     clock_t start, end;
     double cpu_time_used;
 
-    G2Point p1;
-    
-    G2.resetCounters();
-    start = clock();
-    G2.multiMulByScalar(p1, bases, (uint8_t *)scalars, 32, N);
-    end = clock();
-
-    G2.printCounters();
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printf("Time used: %.2lf\n", cpu_time_used);
-    printf("Avg time per exp: %.2lf us\n", (cpu_time_used*1000000)/N);
-    printf("Exps per second: %.2lf\n", (N / cpu_time_used));
+    G2Point p[2];
+
+    // The plain Pippenger buckets and the batch affine accumulators
+    for (int mode=0; mode<2; mode++) {
+        G2.resetCounters();
+        start = clock();
+        if (mode == 0) {
+            G2.multiMulByScalar(p[mode], bases, (uint8_t *)scalars, 32, N);
+        } else {
+            G2.multiMulByScalarBa(p[mode], bases, (uint8_t *)scalars, 32, N);
+        }
+        end = clock();
+
+        printf("%s\n", mode == 0 ? "multiMulByScalar" : "multiMulByScalarBa");
+        G2.printCounters();
+        cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+        printf("Time used: %.2lf\n", cpu_time_used);
+        printf("Avg time per exp: %.2lf us\n", (cpu_time_used*1000000)/N);
+        printf("Exps per second: %.2lf\n", (N / cpu_time_used));
+    }
 
-}
\ No newline at end of file
+    if (!G2.eq(p[0], p[1])) printf("The results do not match\n");
+}
@@ -0,0 +1,26 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "fr.hpp"
+
+int main(int argc, char **argv) {
+
+    int N = atoi(argv[1]);
+
+    RawFr F;
+
+    RawFr::Element a[8];
+    for (int i=0; i<8; i++) {
+        F.fromString(a[i], "99999999999");
+        F.add(a[i], a[i], a[i]);
+    }
+
+    for (int i=0; i<N; i+=8) {
+        F.mulVec(a, a, a, 8);
+    }
+
+    /*
+    char *c1 = Fr_element2str(&a);
+    printf("Result: %s\n", a);
+    free(c1);
+    */
+}
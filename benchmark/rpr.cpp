@@ -0,0 +1,28 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "fr.hpp"
+
+// Round trips of N elements through big endian bytes with the array conversions
+int main(int argc, char **argv) {
+
+    int N = atoi(argv[1]);
+    const int B = 1 << 14;
+
+    RawFr F;
+
+    RawFr::Element *a = new RawFr::Element[B];
+    uint8_t *data = new uint8_t[B * F.bytes()];
+    for (int i=0; i<B; i++) {
+        F.fromUI(a[i], i + 99999999999);
+        F.square(a[i], a[i]);
+    }
+
+    for (int i=0; i<N; i+=B) {
+        F.toRprBEN(a, data, B);
+        F.fromRprBEN(a, data, B);
+    }
+
+    delete[] a;
+    delete[] data;
+}
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <gmp.h>
+#include "fr.hpp"
+
+// Round trips of N elements through big endian bytes with a mpz_t per element, as
+// RawFr::toRprBE and fromRprBE did before the array conversions
+int main(int argc, char **argv) {
+
+    int N = atoi(argv[1]);
+    const int B = 1 << 14;
+
+    RawFr F;
+
+    RawFr::Element *a = new RawFr::Element[B];
+    uint8_t *data = new uint8_t[B * F.bytes()];
+    for (int i=0; i<B; i++) {
+        F.fromUI(a[i], i + 99999999999);
+        F.square(a[i], a[i]);
+    }
+
+    for (int i=0; i<N; i+=B) {
+        for (int j=0; j<B; j++) {
+            mpz_t r;
+            mpz_init(r);
+            F.toMpz(r, a[j]);
+            mpz_export(data + j * F.bytes(), NULL, 1, 8, 1, 0, r);
+            mpz_clear(r);
+        }
+        for (int j=0; j<B; j++) {
+            mpz_t r;
+            mpz_init(r);
+            mpz_import(r, F.bytes(), 1, 1, 0, 0, data + j * F.bytes());
+            F.fromMpz(a[j], r);
+            mpz_clear(r);
+        }
+    }
+
+    delete[] a;
+    delete[] data;
+}
@@ -0,0 +1,22 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "fr.hpp"
+
+// Round trips of N elements through decimal strings
+int main(int argc, char **argv) {
+
+    int N = atoi(argv[1]);
+
+    RawFr F;
+
+    RawFr::Element a;
+    F.fromUI(a, 99999999999);
+    F.square(a, a);
+
+    for (int i=0; i<N; i++) {
+        std::string s = F.toString(a);
+        F.fromString(a, s);
+        F.add(a, a, F.one());
+    }
+}
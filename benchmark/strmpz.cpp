@@ -0,0 +1,35 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "fr.hpp"
+
+// Round trips of N elements through decimal strings with a mpz_t per conversion, as
+// RawFr::toString and fromString did before the GMP-free digits
+int main(int argc, char **argv) {
+
+    int N = atoi(argv[1]);
+
+    RawFr F;
+
+    RawFr::Element a;
+    mpz_t q;
+    mpz_init(q);
+    F.toMpz(q, F.negOne());
+    mpz_add_ui(q, q, 1);
+    F.fromUI(a, 99999999999);
+    F.square(a, a);
+
+    for (int i=0; i<N; i++) {
+        mpz_t r;
+        mpz_init(r);
+        F.toMpz(r, a);
+        char *s = mpz_get_str(0, 10, r);
+        mpz_set_str(r, s, 10);
+        mpz_fdiv_r(r, r, q);
+        F.fromMpz(a, r);
+        free(s);
+        mpz_clear(r);
+        F.add(a, a, F.one());
+    }
+    mpz_clear(q);
+}
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include "fr.hpp"
+#include "vecops.hpp"
+
+// Runs each kernel over arrays of B elements until N elements are processed and prints
+// the time per element and the bandwidth, counting every array read or written once.
+// The unfused versions make a pass per operation, as the loops they replace.
+int main(int argc, char **argv) {
+
+    int64_t N = atoll(argv[1]);
+    const int64_t B = 1 << 21;
+
+    RawFr F;
+    VecOps<RawFr> vec;
+
+    RawFr::Element *a = new RawFr::Element[B];
+    RawFr::Element *b = new RawFr::Element[B];
+    RawFr::Element *c = new RawFr::Element[B];
+    RawFr::Element *r = new RawFr::Element[B];
+    for (int64_t i=0; i<B; i++) {
+        F.fromUI(a[i], i + 99999999999);
+        F.square(a[i], a[i]);
+        F.square(b[i], a[i]);
+        F.square(c[i], b[i]);
+    }
+    RawFr::Element k, g;
+    F.copy(k, a[7]);
+    F.copy(g, a[9]);
+
+    auto run = [&](const char *name, int arrays, std::function<void()> kernel) {
+        kernel();
+        auto t0 = std::chrono::steady_clock::now();
+        int64_t done = 0;
+        for (; done < N; done += B) kernel();
+        auto t1 = std::chrono::steady_clock::now();
+        double secs = std::chrono::duration<double>(t1 - t0).count();
+        printf("%-24s %6.2fns per element %6.2fGB/s\n", name, secs * 1e9 / done, (double)done * arrays * sizeof(RawFr::Element) / secs / 1e9);
+    };
+
+    run("mul", 3, [&]() { vec.mul(r, a, b, B); });
+    run("mulAdd", 4, [&]() { vec.mulAdd(r, a, b, c, B); });
+    run("mulSub", 4, [&]() { vec.mulSub(r, a, b, c, B); });
+    run("mulSub unfused", 6, [&]() {
+        vec.mul(r, a, b, B);
+        #pragma omp parallel for
+        for (int64_t i=0; i<B; i+=VECOPS_BLOCK) F.subN(r + i, r + i, c + i, VECOPS_BLOCK);
+    });
+    run("mulSubScale", 4, [&]() { vec.mulSubScale(r, a, b, c, k, B); });
+    run("mulSubScale unfused", 8, [&]() {
+        vec.mul(r, a, b, B);
+        #pragma omp parallel for
+        for (int64_t i=0; i<B; i+=VECOPS_BLOCK) F.subN(r + i, r + i, c + i, VECOPS_BLOCK);
+        vec.scale(r, r, k, B);
+    });
+    run("axpy", 3, [&]() { vec.axpy(r, k, a, B); });
+    run("axpby", 3, [&]() { vec.axpby(r, k, a, g, b, B); });
+    run("scale", 2, [&]() { vec.scale(r, a, k, B); });
+    run("scalePowers", 2, [&]() { vec.scalePowers(r, a, k, g, B); });
+
+    delete[] a;
+    delete[] b;
+    delete[] c;
+    delete[] r;
+}
@@ -13,6 +13,12 @@ Curve< F2Field<RawFq> > G2(
     "10857046999023057135944570762232829481370756359578518086990519993285655852781, 11559732032986387107991004021392285783925812861821192530917403151452391805634",
     "8495653923123431417604973247489272438418190587263600148770280649306958101930, 4082367875863433681332203403145435568316851327593401208105741076214120093531"
 );
+Glv<RawFq> G1Glv(
+    G1,
+    "2203960485148121921418603742825762020974279258880205651966",
+    "4407920970296243842393367215006156084916469457145843978461",
+    "21888242871839275222246405745257275088548364400416034343698204186575808495617"
+);
 
 Engine Engine::engine;
 
@@ -5,6 +5,7 @@
 #include "fr.hpp"
 #include "f2field.hpp"
 #include "curve.hpp"
+#include "glv.hpp"
 #include <string>
 namespace AltBn128 {
 
@@ -21,6 +22,8 @@ namespace AltBn128 {
     extern RawFr Fr;
     extern Curve<RawFq> G1;
     extern Curve< F2Field<RawFq> > G2;
+    // Endomorphism (x, y) -> (beta*x, y) = lambda*(x, y) of G1
+    extern Glv<RawFq> G1Glv;
 
     class Engine {
     public:
@@ -30,12 +33,14 @@ namespace AltBn128 {
         typedef RawFr Fr;
         typedef Curve<RawFq> G1;
         typedef Curve< F2Field<RawFq> > G2;
+        typedef Glv<RawFq> G1Glv;
 
         F1 f1;
         F2 f2;
         Fr fr;
         G1 g1;
         G2 g2;
+        G1Glv g1Glv;
 
         Engine() : 
             f1(), 
@@ -48,6 +53,12 @@ namespace AltBn128 {
                 "19485874751759354771024239261021720505790618469301721065564631296452457478373, 266929791119991161246907387137283842545076965332900288569378510910307636690",
                 "10857046999023057135944570762232829481370756359578518086990519993285655852781, 11559732032986387107991004021392285783925812861821192530917403151452391805634",
                 "8495653923123431417604973247489272438418190587263600148770280649306958101930, 4082367875863433681332203403145435568316851327593401208105741076214120093531"
+            ),
+            g1Glv(
+                g1,
+                "2203960485148121921418603742825762020974279258880205651966",
+                "4407920970296243842393367215006156084916469457145843978461",
+                "21888242871839275222246405745257275088548364400416034343698204186575808495617"
             ) {}
 
         typedef F1::Element F1Element;
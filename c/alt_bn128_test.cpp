@@ -1,14 +1,28 @@
 #include <gmp.h>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "alt_bn128.hpp"
 #include "fft.hpp"
+#include "polynomial.hpp"
+#include "vecops.hpp"
+#include "counters.hpp"
+#include "fixed_base_table.hpp"
 
 using namespace AltBn128;
 
 namespace {
 
+// Fills size bytes (a multiple of 8) with a xorshift sequence that goes on from seed
+static void randomScalars(uint8_t *r, uint64_t size, uint64_t &seed) {
+    for (uint64_t j=0; j<size; j+=8) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        *(uint64_t *)&r[j] = seed;
+    }
+}
+
 TEST(altBn128, f2_simpleMul) {
 
     F2Element e1;
@@ -271,6 +285,1267 @@ TEST(altBn128, fft) {
 }
 
 
+TEST(altBn128, polynomial) {
+    typedef typename Engine::Fr Field;
+    u_int64_t na = 9000;
+    u_int64_t nb = 2500;
+    u_int64_t nr = na + nb - 1;
+
+    FFT<Field> fft(1<<15);
+    PolynomialArena<Field> arena;
+    Polynomial<Field> poly(fft, arena);
+
+    AltBn128::FrElement *a = new AltBn128::FrElement[na];
+    AltBn128::FrElement *b = new AltBn128::FrElement[nb];
+    AltBn128::FrElement *r = new AltBn128::FrElement[2*na];
+    AltBn128::FrElement *q = new AltBn128::FrElement[nr];
+    AltBn128::FrElement *rem = new AltBn128::FrElement[1024];
+    for (u_int64_t i=0; i<na; i++) {
+        Fr.fromUI(a[i], i + 3);
+        Fr.square(a[i], a[i]);
+        Fr.square(a[i], a[i]);
+    }
+    for (u_int64_t i=0; i<nb; i++) {
+        Fr.fromUI(b[i], 7*i + 1);
+        Fr.square(b[i], b[i]);
+    }
+
+    AltBn128::FrElement z, w, za, zb, zr, zq, aux, aux2;
+    Fr.fromString(z, "12345678901234567890");
+    Fr.fromString(w, "98765432109876543210");
+
+    // Horner by hand
+    poly.evaluate(za, a, na, z);
+    Fr.copy(aux, a[na - 1]);
+    for (u_int64_t i=na-1; i-- > 0;) Fr.mulAdd(aux, aux, z, a[i]);
+    ASSERT_TRUE(Fr.eq(za, aux));
+
+    // FFT, schoolbook and square products
+    poly.evaluate(zb, b, nb, z);
+    poly.mul(r, a, na, b, nb);
+    poly.evaluate(zr, r, nr, z);
+    Fr.mul(aux, za, zb);
+    ASSERT_TRUE(Fr.eq(zr, aux));
+    Fr.mul(aux, a[0], b[0]);
+    ASSERT_TRUE(Fr.eq(r[0], aux));
+    Fr.mul(aux, a[na - 1], b[nb - 1]);
+    ASSERT_TRUE(Fr.eq(r[nr - 1], aux));
+    u_int64_t capacity = arena.capacity();
+
+    poly.mul(r, a, na, b, 20);
+    poly.evaluate(zr, r, na + 19, z);
+    poly.evaluate(zb, b, 20, z);
+    Fr.mul(aux, za, zb);
+    ASSERT_TRUE(Fr.eq(zr, aux));
+
+    poly.mul(r, a, na, a, na);
+    poly.evaluate(zr, r, 2*na - 1, z);
+    Fr.square(aux, za);
+    ASSERT_TRUE(Fr.eq(zr, aux));
+    ASSERT_GE(arena.capacity(), capacity);
+
+    // The merged block has the peak of the live buffers, not the sum of the requests
+    PolynomialArena<Field> nested;
+    auto m0 = nested.mark();
+    nested.alloc(100);
+    auto m1 = nested.mark();
+    nested.alloc(50);
+    nested.release(m1);
+    nested.alloc(50);
+    nested.release(m0);
+    ASSERT_EQ(nested.capacity(), 150u);
+
+    // a = q * (X^n - 1) + rem
+    u_int64_t n = 1024;
+    ASSERT_FALSE(poly.divByXnMinus1(q, a, na, n, rem));
+    poly.evaluate(zq, q, na - n, w);
+    poly.evaluate(zr, rem, n, w);
+    Fr.exp(aux2, w, (uint8_t *)&n, sizeof(n));
+    Fr.sub(aux2, aux2, Fr.one());
+    Fr.mulAdd(aux, zq, aux2, zr);
+    poly.evaluate(zr, a, na, w);
+    ASSERT_TRUE(Fr.eq(aux, zr));
+
+    // An exact multiple, divided in place
+    for (u_int64_t i=0; i<na; i++) {
+        Fr.neg(r[i], i < na - n ? q[i] : Fr.zero());
+        if (i >= n) Fr.add(r[i], r[i], q[i - n]);
+    }
+    ASSERT_TRUE(poly.divByXnMinus1(r, r, na, n));
+    for (u_int64_t i=0; i<na - n; i++) ASSERT_TRUE(Fr.eq(r[i], q[i]));
+
+    // a = q * (X - z) + a(z), in place too
+    aux = poly.divByXMinusZ(q, a, na, z);
+    ASSERT_TRUE(Fr.eq(aux, za));
+    poly.evaluate(zq, q, na - 1, w);
+    Fr.sub(aux2, w, z);
+    Fr.mulAdd(aux, zq, aux2, za);
+    poly.evaluate(zr, a, na, w);
+    ASSERT_TRUE(Fr.eq(aux, zr));
+    for (u_int64_t i=0; i<na; i++) Fr.copy(r[i], a[i]);
+    aux = poly.divByXMinusZ(r, r, na, z);
+    ASSERT_TRUE(Fr.eq(aux, za));
+    for (u_int64_t i=0; i<na - 1; i++) ASSERT_TRUE(Fr.eq(r[i], q[i]));
+
+    // r = 3 * r + 5 * b, with r as a result and as a term
+    AltBn128::FrElement coefs[2];
+    Fr.fromUI(coefs[0], 3);
+    Fr.fromUI(coefs[1], 5);
+    const AltBn128::FrElement *polys[2] = { r, b };
+    u_int64_t sizes[2] = { na - 1, nb };
+    poly.evaluate(zq, r, na - 1, w);
+    poly.evaluate(zb, b, nb, w);
+    poly.linearCombination(r, coefs, polys, sizes, 2);
+    poly.evaluate(zr, r, na - 1, w);
+    Fr.mul(aux, coefs[0], zq);
+    Fr.mulAdd(aux, coefs[1], zb, aux);
+    ASSERT_TRUE(Fr.eq(aux, zr));
+
+    delete[] a;
+    delete[] b;
+    delete[] r;
+    delete[] q;
+    delete[] rem;
+}
+
+TEST(altBn128, vecOps) {
+    typedef typename Engine::Fr Field;
+    int N = 3000;
+
+    VecOps<Field> vec;
+    AltBn128::FrElement *a = new AltBn128::FrElement[N];
+    AltBn128::FrElement *b = new AltBn128::FrElement[N];
+    AltBn128::FrElement *c = new AltBn128::FrElement[N];
+    AltBn128::FrElement *r = new AltBn128::FrElement[N];
+    for (int i=0; i<N; i++) {
+        Fr.fromUI(a[i], i + 1);
+        Fr.square(a[i], a[i]);
+        Fr.fromUI(b[i], 3*i + 7);
+        Fr.square(b[i], b[i]);
+        Fr.square(b[i], b[i]);
+        Fr.fromUI(c[i], 5*i + 2);
+        Fr.square(c[i], c[i]);
+        Fr.square(c[i], c[i]);
+        Fr.square(c[i], c[i]);
+    }
+    AltBn128::FrElement k, g, p;
+    Fr.fromString(k, "12345678901234567890");
+    Fr.fromString(g, "98765432109876543210");
+
+    vec.mul(r, a, b, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.mul(a[i], b[i])));
+    vec.square(r, a, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.mul(a[i], a[i])));
+    vec.mulAdd(r, a, b, c, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.add(Fr.mul(a[i], b[i]), c[i])));
+    vec.mulSub(r, a, b, c, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.sub(Fr.mul(a[i], b[i]), c[i])));
+    vec.mulSubScale(r, a, b, c, k, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.mul(Fr.sub(Fr.mul(a[i], b[i]), c[i]), k)));
+    vec.axpby(r, k, a, g, b, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.add(Fr.mul(k, a[i]), Fr.mul(g, b[i]))));
+    vec.scale(r, a, k, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.mul(a[i], k)));
+
+    Fr.copy(p, k);
+    vec.scalePowers(r, a, k, g, N);
+    for (int i=0; i<N; i++) {
+        ASSERT_TRUE(Fr.eq(r[i], Fr.mul(a[i], p)));
+        Fr.mul(p, p, g);
+    }
+
+    // In place
+    for (int i=0; i<N; i++) Fr.copy(r[i], c[i]);
+    vec.axpy(r, k, a, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.add(c[i], Fr.mul(k, a[i]))));
+    for (int i=0; i<N; i++) Fr.copy(r[i], a[i]);
+    vec.mulSub(r, r, b, c, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.sub(Fr.mul(a[i], b[i]), c[i])));
+    for (int i=0; i<N; i++) Fr.copy(r[i], c[i]);
+    vec.mulAdd(r, a, b, r, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(Fr.eq(r[i], Fr.add(Fr.mul(a[i], b[i]), c[i])));
+
+    delete[] a;
+    delete[] b;
+    delete[] c;
+    delete[] r;
+}
+
+struct TestCounters {
+    uint64_t a;
+    uint64_t b;
+};
+
+TEST(altBn128, threadCounters) {
+    typedef ThreadCounters<TestCounters, TestCounters> Registry;
+    int nThreads = 4;
+    int N = 100000;
+    std::vector<std::thread> threads;
+    for (int t=0; t<nThreads; t++) {
+        threads.push_back(std::thread([N, t]() {
+            for (int i=0; i<N; i++) Registry::local().a++;
+            Registry::local().b += t;
+        }));
+    }
+    for (auto &t : threads) t.join();
+    TestCounters c = Registry::total();
+    ASSERT_EQ(c.a, (uint64_t)nThreads * N);
+    ASSERT_EQ(c.b, (uint64_t)(nThreads * (nThreads - 1) / 2));
+
+    // The slots of the finished threads are reused and keep their counts
+    std::thread([]() { Registry::local().a++; }).join();
+    ASSERT_EQ(Registry::total().a, (uint64_t)nThreads * N + 1);
+    Registry::local().b++;
+    Registry::reset();
+    c = Registry::total();
+    ASSERT_EQ(c.a, 0u);
+    ASSERT_EQ(c.b, 0u);
+}
+
+TEST(altBn128, fq_mulVec) {
+    int N = 37;
+
+    F1Element *a = new F1Element[N];
+    F1Element *b = new F1Element[N];
+    F1Element *r = new F1Element[N];
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(a[i], i+1);
+        F1.fromUI(b[i], 3*i+7);
+        F1.square(a[i], a[i]);
+        F1.mul(b[i], b[i], a[i]);
+    }
+    F1.copy(a[0], F1.negOne());
+    F1.copy(b[0], F1.negOne());
+
+    F1Element aux;
+
+    F1.mulVec(r, a, b, N);
+    for (int i=0; i<N; i++) {
+        F1.mul(aux, a[i], b[i]);
+        ASSERT_TRUE(F1.eq(r[i], aux));
+    }
+
+    F1.squareVec(r, a, N);
+    for (int i=0; i<N; i++) {
+        F1.square(aux, a[i]);
+        ASSERT_TRUE(F1.eq(r[i], aux));
+    }
+
+    delete[] a;
+    delete[] b;
+    delete[] r;
+}
+
+// The static initialization of this file can run before the one of fq.cpp, the kernels
+// must already be selected for the CPU
+static const char *initScalarKernels = Fq_kernels.scalar;
+static const char *initVecKernels = Fq_kernels.vec;
+static FqRawElement initProduct;
+static bool initProductDone = ([]() {
+    FqRawElement a = {3, 5, 7, 11};
+    Fq_kernels.rawMMul(initProduct, a, a);
+    return true;
+})();
+
+TEST(altBn128, fq_kernelsStaticInit) {
+    ASSERT_TRUE(initProductDone);
+    ASSERT_STREQ(initScalarKernels, Fq_kernels.scalar);
+    ASSERT_STREQ(initVecKernels, Fq_kernels.vec);
+    FqRawElement a = {3, 5, 7, 11}, r;
+    Fq_kernels.rawMMul(r, a, a);
+    ASSERT_EQ(memcmp(r, initProduct, sizeof(r)), 0);
+}
+
+TEST(altBn128, fq_kernels) {
+    int N = 21;
+
+    F1Element *a = new F1Element[N];
+    F1Element *b = new F1Element[N];
+    F1Element *r = new F1Element[N];
+    F1Element *s = new F1Element[N];
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(a[i], i+1);
+        F1.fromUI(b[i], 5*i+2);
+        F1.square(a[i], a[i]);
+        F1.mul(b[i], b[i], a[i]);
+        F1.mul(s[i], a[i], b[i]);
+    }
+
+    // Every variant available in this CPU gives the same products
+    const char *scalars[] = {"adx", "generic", "cpp"};
+    const char *vecs[] = {"ifma", "avx2", "scalar"};
+    for (int i=0; i<3; i++) {
+        for (int j=0; j<3; j++) {
+            if (!Fq_setKernels(scalars[i], vecs[j])) continue;
+            ASSERT_STREQ(Fq_kernels.scalar, scalars[i]);
+            ASSERT_STREQ(Fq_kernels.vec, vecs[j]);
+            for (int k=0; k<N; k++) {
+                F1.mul(r[k], a[k], b[k]);
+                ASSERT_TRUE(F1.eq(r[k], s[k]));
+            }
+            F1.mulVec(r, a, b, N);
+            for (int k=0; k<N; k++) {
+                ASSERT_TRUE(F1.eq(r[k], s[k]));
+            }
+#ifdef Fq_HAS_ELEMENT_API
+            // The element level API goes through the same table
+            for (int k=0; k<N; k++) {
+                FqElement ea, eb, er;
+                ea.type = Fq_LONGMONTGOMERY;
+                eb.type = Fq_LONGMONTGOMERY;
+                memcpy(ea.longVal, a[k].v, sizeof(ea.longVal));
+                memcpy(eb.longVal, b[k].v, sizeof(eb.longVal));
+                Fq_mul(&er, &ea, &eb);
+                ASSERT_EQ(memcmp(er.longVal, s[k].v, sizeof(er.longVal)), 0);
+                Fq_toNormal(&er, &ea);
+                Fq_toMontgomery(&er, &er);
+                ASSERT_EQ(memcmp(er.longVal, a[k].v, sizeof(er.longVal)), 0);
+                eb.type = Fq_SHORT;
+                eb.shortVal = -(k+2);
+                Fq_mul(&er, &ea, &eb);
+                Fq_toMontgomery(&er, &er);
+                F1.fromUI(r[k], k+2);
+                F1.neg(r[k], r[k]);
+                F1.mul(r[k], r[k], a[k]);
+                ASSERT_EQ(memcmp(er.longVal, r[k].v, sizeof(er.longVal)), 0);
+            }
+#endif
+        }
+    }
+    ASSERT_FALSE(Fq_setKernels("none", NULL));
+    Fq_selectKernels(false);
+
+    delete[] a;
+    delete[] b;
+    delete[] r;
+    delete[] s;
+}
+
+TEST(altBn128, fq_arrayOps) {
+    int N = 33;
+
+    F1Element *a = new F1Element[N];
+    F1Element *b = new F1Element[N];
+    F1Element *r = new F1Element[N];
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(a[i], i+1);
+        F1.fromUI(b[i], 5*i+2);
+        F1.mul(b[i], b[i], b[i]);
+    }
+    F1.copy(a[0], F1.negOne());
+
+    F1Element aux;
+
+    F1.addN(r, a, b, N);
+    for (int i=0; i<N; i++) {
+        F1.add(aux, a[i], b[i]);
+        ASSERT_TRUE(F1.eq(r[i], aux));
+    }
+
+    F1.subN(r, a, b, N);
+    for (int i=0; i<N; i++) {
+        F1.sub(aux, a[i], b[i]);
+        ASSERT_TRUE(F1.eq(r[i], aux));
+    }
+
+    F1.mulN(r, a, b[3], N);
+    for (int i=0; i<N; i++) {
+        F1.mul(aux, a[i], b[3]);
+        ASSERT_TRUE(F1.eq(r[i], aux));
+    }
+
+    // Reversed result
+    F1.mulN(r + N - 1, a, b, N, -(int64_t)sizeof(F1Element), sizeof(F1Element), sizeof(F1Element));
+    for (int i=0; i<N; i++) {
+        F1.mul(aux, a[i], b[i]);
+        ASSERT_TRUE(F1.eq(r[N - 1 - i], aux));
+    }
+
+    F1.batchInverse(r, b, N);
+    for (int i=0; i<N; i++) {
+        F1.mul(aux, r[i], b[i]);
+        ASSERT_TRUE(F1.eq(aux, F1.one()));
+    }
+
+    delete[] a;
+    delete[] b;
+    delete[] r;
+}
+
+TEST(altBn128, fq_batchInverseParallel) {
+    int N = 5000;
+
+    F1Element *a = new F1Element[N];
+    F1Element *r = new F1Element[N];
+    F1Element *scratch = new F1Element[N];
+    F1Element aux;
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(a[i], 3*i+1);
+        F1.square(a[i], a[i]);
+    }
+
+    int nThreads[] = {0, 1, 3, 8};
+    for (int t=0; t<4; t++) {
+        F1.batchInverseParallel(r, a, N, nThreads[t]);
+        for (int i=0; i<N; i++) {
+            F1.mul(aux, r[i], a[i]);
+            ASSERT_TRUE(F1.eq(aux, F1.one()));
+        }
+    }
+
+    // In place with caller scratch
+    F1.copyN(r, a, N);
+    F1.batchInverseParallel(r, r, N, 4, scratch);
+    for (int i=0; i<N; i++) {
+        F1.mul(aux, r[i], a[i]);
+        ASSERT_TRUE(F1.eq(aux, F1.one()));
+    }
+
+    F1.batchInverseParallel(r, a, 1, 4);
+    F1.mul(aux, r[0], a[0]);
+    ASSERT_TRUE(F1.eq(aux, F1.one()));
+
+    delete[] a;
+    delete[] r;
+    delete[] scratch;
+}
+
+TEST(altBn128, fq_rpr) {
+    int N = 600;
+    int bytes = F1.bytes();
+
+    F1Element *a = new F1Element[N];
+    F1Element *r = new F1Element[N];
+    uint8_t *be = new uint8_t[N*bytes];
+    uint8_t *le = new uint8_t[N*bytes];
+    uint8_t ref[bytes];
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(a[i], i);
+        F1.square(a[i], a[i]);
+        F1.square(a[i], a[i]);
+        F1.square(a[i], a[i]);
+    }
+    F1.copy(a[1], F1.negOne());
+
+    F1.toRprBEN(a, be, N);
+    F1.toRprLEN(a, le, N);
+    mpz_t m;
+    mpz_init(m);
+    for (int i=0; i<N; i++) {
+        memset(ref, 0, bytes);
+        F1.toMpz(m, a[i]);
+        mpz_export(ref, NULL, -1, 1, 0, 0, m);
+        for (int j=0; j<bytes; j++) {
+            ASSERT_EQ(le[i*bytes + j], ref[j]);
+            ASSERT_EQ(be[i*bytes + j], ref[bytes - 1 - j]);
+        }
+        F1.toRprBE(a[i], ref, bytes);
+        ASSERT_EQ(memcmp(ref, be + i*bytes, bytes), 0);
+    }
+    mpz_clear(m);
+
+    F1.fromRprBEN(r, be, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(F1.eq(r[i], a[i]));
+    F1.fromRprLEN(r, le, N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(F1.eq(r[i], a[i]));
+    F1.fromRprBE(r[0], be + 5*bytes, bytes);
+    ASSERT_TRUE(F1.eq(r[0], a[5]));
+
+    F1.toRprLEN(a, le, N, true);
+    ASSERT_EQ(memcmp(le, a, N*bytes), 0);
+    F1.fromRprLEN(r, le, N, true);
+    for (int i=0; i<N; i++) ASSERT_TRUE(F1.eq(r[i], a[i]));
+
+    // Values over q are reduced
+    F1Element aux;
+    memset(be, 0xFF, bytes);
+    F1.fromRprBEN(r, be, 1);
+    F1.fromString(aux, "115792089237316195423570985008687907853269984665640564039457584007913129639935");
+    ASSERT_TRUE(F1.eq(r[0], aux));
+
+    delete[] a;
+    delete[] r;
+    delete[] be;
+    delete[] le;
+}
+
+TEST(altBn128, fq_strings) {
+    int N = 600;
+    F1Element aux;
+
+    F1.fromString(aux, "-1");
+    ASSERT_TRUE(F1.eq(aux, F1.negOne()));
+    ASSERT_EQ(F1.toString(aux), "21888242871839275222246405745257275088696311157297823662689037894645226208582");
+    ASSERT_EQ(F1.toString(aux, 16), "30644e72e131a029b85045b68181585d97816a916871ca8d3c208c16d87cfd46");
+    F1.fromString(aux, "0x30644E72E131A029B85045B68181585D97816A916871CA8D3C208C16D87CFD48", 16);
+    ASSERT_TRUE(F1.eq(aux, F1.one()));
+    ASSERT_EQ(F1.toString(F1.zero()), "0");
+    ASSERT_EQ(F1.toString(F1.zero(), 16), "0");
+
+    // Longer than two fields
+    F1Element aux2;
+    F1.fromString(aux, "115792089237316195423570985008687907853269984665640564039457584007913129639935115792089237316195423570985008687907853269984665640564039457584007913129639935");
+    mpz_t m;
+    mpz_init_set_str(m, "115792089237316195423570985008687907853269984665640564039457584007913129639935115792089237316195423570985008687907853269984665640564039457584007913129639935", 10);
+    mpz_t q;
+    mpz_init_set_str(q, "21888242871839275222246405745257275088696311157297823662689037894645226208583", 10);
+    mpz_fdiv_r(m, m, q);
+    mpz_clear(q);
+    F1.fromMpz(aux2, m);
+    ASSERT_TRUE(F1.eq(aux, aux2));
+
+    F1Element *a = new F1Element[N];
+    F1Element *r = new F1Element[N];
+    std::string json = "[";
+    for (int i=0; i<N; i++) {
+        F1.fromUI(a[i], i);
+        F1.square(a[i], a[i]);
+        F1.square(a[i], a[i]);
+        F1.square(a[i], a[i]);
+        F1.toMpz(m, a[i]);
+        char *ref = mpz_get_str(0, 10, m);
+        ASSERT_EQ(F1.toString(a[i]), ref);
+        free(ref);
+        ref = mpz_get_str(0, 16, m);
+        ASSERT_EQ(F1.toString(a[i], 16), ref);
+        free(ref);
+        F1.fromString(aux, F1.toString(a[i], 16), 16);
+        ASSERT_TRUE(F1.eq(aux, a[i]));
+        json += (i ? ", \"" : "\"") + F1.toString(a[i]) + "\"";
+    }
+    json += "]";
+    mpz_clear(m);
+
+    ASSERT_EQ(F1.fromStringN(r, json.c_str(), json.size(), N), N);
+    for (int i=0; i<N; i++) ASSERT_TRUE(F1.eq(r[i], a[i]));
+    ASSERT_EQ(F1.fromStringN(r, json.c_str(), json.size(), 10, 10, 4), 10);
+    ASSERT_EQ(F1.fromStringN(r, json.c_str(), json.size(), N, 8), -1);
+
+    delete[] a;
+    delete[] r;
+}
+
+TEST(altBn128, fq_batchInverseFrontDoor) {
+    int N = 3000;
+
+    F1Element *a = new F1Element[N];
+    F1Element *r = new F1Element[N];
+    F1Element *scratch = new F1Element[N];
+    F1Element *s = new F1Element[2*N];
+    F1Element aux;
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(a[i], 7*i+2);
+        F1.square(a[i], a[i]);
+    }
+
+    RawFq::BatchInverseTuning saved = F1.batchInverseTuning;
+    RawFq::BatchInverseTuning tunings[] = { {1, 1}, {INT64_MAX, INT64_MAX}, {1024, 2048} };
+    for (int t=0; t<3; t++) {
+        F1.batchInverseTuning = tunings[t];
+
+        F1.batchInverse(r, a, N, NULL);
+        for (int i=0; i<N; i++) {
+            F1.mul(aux, r[i], a[i]);
+            ASSERT_TRUE(F1.eq(aux, F1.one()));
+        }
+
+        F1.copyN(r, a, N);
+        F1.batchInverse(r, r, N, scratch);
+        for (int i=0; i<N; i++) {
+            F1.mul(aux, r[i], a[i]);
+            ASSERT_TRUE(F1.eq(aux, F1.one()));
+        }
+
+        // Inverses of a in the odd elements of s
+        F1.batchInverse(s + 1, a, N, NULL, 2*sizeof(F1Element), sizeof(F1Element));
+        for (int i=0; i<N; i++) {
+            F1.mul(aux, s[2*i+1], a[i]);
+            ASSERT_TRUE(F1.eq(aux, F1.one()));
+        }
+    }
+
+    F1.batchInverseCalibrate(1 << 12);
+    ASSERT_TRUE(F1.saveBatchInverseTuning("fq_tuning.txt"));
+    RawFq::BatchInverseTuning calibrated = F1.batchInverseTuning;
+    F1.batchInverseTuning = saved;
+    ASSERT_TRUE(F1.loadBatchInverseTuning("fq_tuning.txt"));
+    ASSERT_EQ(F1.batchInverseTuning.prefetchMin, calibrated.prefetchMin);
+    ASSERT_EQ(F1.batchInverseTuning.parallelMin, calibrated.parallelMin);
+    remove("fq_tuning.txt");
+    // Sizes below the smallest measured one are measured at it
+    F1.batchInverseCalibrate(0);
+    F1.batchInverseTuning = saved;
+
+    delete[] a;
+    delete[] r;
+    delete[] scratch;
+    delete[] s;
+}
+
+TEST(altBn128, g1_multiAdd) {
+    int N = 10;
+    G1PointAffine p1[N], p2[N], p3[N];
+    G1Point p, q;
+
+    G1.copy(p, G1.one());
+    for (int i=0; i<N; i++) {
+        G1.copy(p1[i], p);
+        G1.dbl(q, p);
+        G1.copy(p2[i], q);
+        G1.add(p, p, G1.one());
+    }
+    G1.copy(p2[1], p1[1]);
+    G1.copy(p2[3], G1.zeroAffine());
+
+    G1.multiAdd(p3, p1, p2, N);
+    for (int i=0; i<N; i++) {
+        G1.add(q, p1[i], p2[i]);
+        ASSERT_TRUE(G1.eq(q, p3[i])) << i;
+    }
+}
+
+TEST(altBn128, batchToAffine) {
+    int N = 100;
+    G1Point *p1 = new G1Point[N];
+    G1PointAffine *a1 = new G1PointAffine[N];
+    G2Point *p2 = new G2Point[N];
+    G2PointAffine *a2 = new G2PointAffine[N];
+
+    G1.copy(p1[0], G1.one());
+    G2.copy(p2[0], G2.one());
+    for (int i=1; i<N; i++) {
+        G1.add(p1[i], p1[i-1], p1[i-1]);
+        G1.add(p1[i], p1[i], G1.one());
+        G2.add(p2[i], p2[i-1], p2[i-1]);
+        G2.add(p2[i], p2[i], G2.one());
+    }
+    G1.copy(p1[0], G1.zero());
+    G1.copy(p1[7], G1.zero());
+    G2.copy(p2[N-1], G2.zero());
+
+    G1.batchToAffine(a1, p1, N);
+    G2.batchToAffine(a2, p2, N);
+    for (int i=0; i<N; i++) {
+        G1PointAffine r1;
+        G2PointAffine r2;
+        G1.copy(r1, p1[i]);
+        G2.copy(r2, p2[i]);
+        ASSERT_TRUE(G1.eq(r1, a1[i])) << i;
+        ASSERT_TRUE(G2.eq(r2, a2[i])) << i;
+    }
+    ASSERT_TRUE(G1.isZero(a1[7]));
+    ASSERT_TRUE(G2.isZero(a2[N-1]));
+
+    delete[] p1;
+    delete[] a1;
+    delete[] p2;
+    delete[] a2;
+}
+
+TEST(altBn128, fixedBaseTable) {
+    int N = 4100;
+    typedef uint8_t Scalar[32];
+    Scalar *scalars = new Scalar[N];
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    randomScalars((uint8_t *)scalars, N*32, seed);
+    memset(scalars[1], 0, 32);
+    memset(scalars[2], 0xFF, 32);
+    memset(scalars[3], 0x80, 32);
+
+    G1Point p1, p2;
+    uint32_t windows[] = { 2, 5, 8, 13 };
+    for (uint32_t w : windows) {
+        FixedBaseTable<Curve<RawFq>> t(G1, G1.oneAffine(), 32, w);
+        for (int i=0; i<20; i++) {
+            G1.mulByScalar(p1, G1.one(), scalars[i], 32);
+            t.mul(p2, scalars[i]);
+            ASSERT_TRUE(G1.eq(p1, p2)) << w << " " << i;
+        }
+    }
+
+    // Shorter scalars, more than a block
+    G1PointAffine base;
+    G1PointAffine *r = new G1PointAffine[N*4];
+    G1.mulByScalar(p1, G1.one(), scalars[9], 32);
+    G1.copy(base, p1);
+    FixedBaseTable<Curve<RawFq>> t(G1, base, 8, 4);
+    t.mulMany(r, (uint8_t *)scalars, N*4);
+    for (int i=0; i<N*4; i+=37) {
+        G1.mulByScalar(p1, base, scalars[0] + i*8, 8);
+        ASSERT_TRUE(G1.eq(p1, r[i])) << i;
+    }
+    ASSERT_TRUE(G1.isZero(r[4]));
+
+    FixedBaseTable<Curve< F2Field<RawFq> >> t2(G2, G2.oneAffine(), 32, 6);
+    for (int i=0; i<5; i++) {
+        G2Point q1, q2;
+        G2.mulByScalar(q1, G2.one(), scalars[i], 32);
+        t2.mul(q2, scalars[i]);
+        ASSERT_TRUE(G2.eq(q1, q2)) << i;
+    }
+
+    ASSERT_EQ(FixedBaseTable<Curve<RawFq>>::tableSize(32, 8), 33 * 128 * sizeof(G1PointAffine));
+    ASSERT_EQ(FixedBaseTable<Curve<RawFq>>::windowBitsForSize(32, 33 * 128 * sizeof(G1PointAffine)), 8);
+
+    delete[] r;
+    delete[] scalars;
+}
+
+TEST(altBn128, wnaf) {
+    uint8_t s[80];
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    int8_t naf[80*8+1];
+    mpz_t k, v, d;
+    mpz_inits(k, v, d, NULL);
+    for (int it=0; it<200; it++) {
+        randomScalars(s, 80, seed);
+        if (it==1) memset(s, 0xFF, 80);
+        if (it==2) memset(s, 0, 80);
+        unsigned int size = 1 + it % 40;
+        unsigned int w = 2 + it % (WNAF_MAX_WIDTH-1);
+        int len = buildWNaf(naf, s, size, w);
+        ASSERT_LE(len, (int)size*8+1);
+        mpz_set_ui(v, 0);
+        int lastNonZero = len + (int)w;
+        for (int i=len-1; i>=0; i--) {
+            mpz_mul_2exp(v, v, 1);
+            if (naf[i]) {
+                ASSERT_TRUE(naf[i] & 1);
+                ASSERT_LT(abs(naf[i]), 1 << (w-1));
+                ASSERT_GE(lastNonZero - i, (int)w);
+                lastNonZero = i;
+                if (naf[i] > 0) mpz_add_ui(v, v, naf[i]); else mpz_sub_ui(v, v, -naf[i]);
+            }
+        }
+        mpz_import(k, size, -1, 1, 0, 0, s);
+        ASSERT_EQ(mpz_cmp(k, v), 0) << it;
+
+        if (it<40) {
+            G1Point p1, p2;
+            G1.copy(p1, G1.one());
+            G1.dbl(p1, p1);
+            G1.copy(p2, p1);
+            wnafMulByScalar<Curve<RawFq>, G1Point>(G1, p2, p2, s, size, w);
+            nafMulByScalar<Curve<RawFq>, G1Point, G1Point>(G1, p1, p1, s, size);
+            ASSERT_TRUE(G1.eq(p1, p2)) << it;
+            G1.mulByScalar(p2, G1.oneAffine(), s, size);
+            nafMulByScalar<Curve<RawFq>, G1PointAffine, G1Point>(G1, p1, G1.oneAffine(), s, size);
+            ASSERT_TRUE(G1.eq(p1, p2)) << it;
+        }
+    }
+    mpz_clears(k, v, d, NULL);
+
+    // Scalars recoded in the heap, the zero point and G2
+    G1Point p1, p2;
+    G1.mulByScalar(p1, G1.one(), s, 80);
+    nafMulByScalar<Curve<RawFq>, G1Point, G1Point>(G1, p2, G1.one(), s, 80);
+    ASSERT_TRUE(G1.eq(p1, p2));
+    G1.mulByScalar(p1, G1.zero(), s, 32);
+    ASSERT_TRUE(G1.isZero(p1));
+    G2Point q1, q2;
+    G2.mulByScalar(q1, G2.one(), s, 32);
+    nafMulByScalar<Curve< F2Field<RawFq> >, G2Point, G2Point>(G2, q2, G2.one(), s, 32);
+    ASSERT_TRUE(G2.eq(q1, q2));
+
+    // Widths out of the tables
+    int8_t nafOut[32*8+1];
+    ASSERT_THROW(buildWNaf(nafOut, s, 32, 1), std::invalid_argument);
+    ASSERT_THROW(buildWNaf(nafOut, s, 32, WNAF_MAX_WIDTH+1), std::invalid_argument);
+    ASSERT_THROW((wnafMulByScalar<Curve<RawFq>, G1Point>(G1, p1, p1, s, 32, WNAF_MAX_WIDTH+1)), std::invalid_argument);
+}
+
+TEST(altBn128, batchMulByScalar) {
+    int N = 1500;
+    typedef uint8_t Scalar[32];
+    Scalar *scalars = new Scalar[N];
+    G1PointAffine *bases = new G1PointAffine[N];
+    G1PointAffine *r = new G1PointAffine[N];
+
+    G1.copy(bases[0], G1.one());
+    G1.copy(bases[1], G1.one());
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i=0; i<N; i++) {
+        if (i>1) G1.add(bases[i], bases[i-1], bases[i-2]);
+        randomScalars(scalars[i], 32, seed);
+    }
+    // Zero scalar and base, a short scalar and the order, which adds opposite points
+    memset(scalars[2], 0, 32);
+    G1.copy(bases[3], G1.zeroAffine());
+    memset(scalars[4] + 1, 0, 31);
+    mpz_t o;
+    mpz_init_set_str(o, "21888242871839275222246405745257275088548364400416034343698204186575808495617", 10);
+    memset(scalars[5], 0, 32);
+    mpz_export(scalars[5], NULL, -1, 1, 0, 0, o);
+    mpz_clear(o);
+
+    G1.batchMulByScalar(r, bases, (uint8_t *)scalars, 32, N);
+    for (int i=0; i<N; i++) {
+        G1Point p;
+        G1.mulByScalar(p, bases[i], scalars[i], 32);
+        ASSERT_TRUE(G1.eq(p, r[i])) << i;
+    }
+    ASSERT_TRUE(G1.isZero(r[5]));
+
+    // In place, with 8 byte scalars, and in G2
+    G1PointAffine orig[100];
+    for (int i=0; i<100; i++) G1.copy(orig[i], bases[i]);
+    G1.batchMulByScalar(bases, bases, (uint8_t *)scalars, 8, 100);
+    for (int i=0; i<100; i++) {
+        G1Point p;
+        G1.mulByScalar(p, orig[i], scalars[0] + i*8, 8);
+        ASSERT_TRUE(G1.eq(p, bases[i])) << i;
+    }
+    // multiDbl in place with a zero, and multiAdd of opposite points
+    G1PointAffine d[4], e[4];
+    for (int i=0; i<4; i++) G1.copy(d[i], orig[i+2]);
+    G1.copy(d[1], G1.zeroAffine());
+    G1.multiDbl(d, d, 4);
+    for (int i=0; i<4; i++) {
+        G1Point p;
+        if (i==1) G1.copy(p, G1.zero()); else G1.dbl(p, orig[i+2]);
+        ASSERT_TRUE(G1.eq(p, d[i])) << i;
+        G1.neg(e[i], d[i]);
+    }
+    G1.multiAdd(e, d, e, 4);
+    for (int i=0; i<4; i++) ASSERT_TRUE(G1.isZero(e[i])) << i;
+    // In place over either input, with a zero p2, a zero p1, a doubling and an addition
+    G1PointAffine x[4], y[4], sep[4];
+    for (int i=0; i<4; i++) {
+        G1.copy(x[i], orig[i+2]);
+        G1.copy(y[i], orig[i+6]);
+    }
+    G1.copy(y[0], G1.zeroAffine());
+    G1.copy(x[1], G1.zeroAffine());
+    G1.copy(y[2], x[2]);
+    G1.multiAdd(sep, x, y, 4);
+    for (int k=0; k<2; k++) {
+        G1PointAffine p1[4], p2[4];
+        for (int i=0; i<4; i++) {
+            G1.copy(p1[i], x[i]);
+            G1.copy(p2[i], y[i]);
+        }
+        G1.multiAdd(k ? p2 : p1, p1, p2, 4);
+        for (int i=0; i<4; i++) ASSERT_TRUE(G1.eq(k ? p2[i] : p1[i], sep[i])) << k << " " << i;
+    }
+    for (int i=0; i<4; i++) {
+        G1Point p;
+        G1.add(p, x[i], y[i]);
+        ASSERT_TRUE(G1.eq(p, sep[i])) << i;
+    }
+
+    G2PointAffine b2[10], r2[10];
+    G2.copy(b2[0], G2.one());
+    for (int i=1; i<10; i++) G2.add(b2[i], b2[i-1], G2.one());
+    G2.batchMulByScalar(r2, b2, (uint8_t *)scalars, 32, 10);
+    for (int i=0; i<10; i++) {
+        G2Point p;
+        G2.mulByScalar(p, b2[i], scalars[i], 32);
+        ASSERT_TRUE(G2.eq(p, r2[i])) << i;
+    }
+
+    delete[] r;
+    delete[] bases;
+    delete[] scalars;
+}
+
+TEST(altBn128, g2_multiExpBa) {
+    int N = 3000;
+
+    typedef uint8_t Scalar[32];
+    Scalar *scalars = new Scalar[N];
+    G2PointAffine *bases = new G2PointAffine[N];
+
+    G2.copy(bases[0], G2.one());
+    G2.copy(bases[1], G2.one());
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i=0; i<N; i++) {
+        if (i>1) G2.add(bases[i], bases[i-1], bases[i-2]);
+        randomScalars(scalars[i], 32, seed);
+        scalars[i][31] &= 0x1F;
+    }
+    // Repeated bases and scalars take the doubling path of multiAdd
+    for (int j=0; j<32; j++) scalars[5][j] = scalars[4][j];
+    G2.copy(bases[5], bases[4]);
+
+    G2Point p1, p2;
+    G2.multiMulByScalar(p1, bases, (uint8_t *)scalars, 32, N);
+    G2.multiMulByScalarBa(p2, bases, (uint8_t *)scalars, 32, N);
+    ASSERT_TRUE(G2.eq(p1, p2));
+
+    delete[] bases;
+    delete[] scalars;
+}
+
+TEST(altBn128, g1_glv) {
+    const char *lambda = "4407920970296243842393367215006156084916469457145843978461";
+    const char *order = "21888242871839275222246405745257275088548364400416034343698204186575808495617";
+    mpz_t k, k1, k2, l, r;
+    mpz_inits(k, k1, k2, l, r, NULL);
+    mpz_set_str(l, lambda, 10);
+    mpz_set_str(r, order, 10);
+
+    // phi(P) = lambda*P
+    uint8_t sl[32] = {0};
+    mpz_export(sl, NULL, -1, 1, 0, 0, l);
+    G1Point p1, p2;
+    G1PointAffine pa;
+    G1Glv.endomorphism(pa, G1.oneAffine());
+    G1.mulByScalar(p1, G1.one(), sl, 32);
+    ASSERT_TRUE(G1.eq(p1, pa));
+    G1Glv.endomorphism(p2, p1);
+    G1.mulByScalar(p1, p1, sl, 32);
+    ASSERT_TRUE(G1.eq(p1, p2));
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i=0; i<1000; i++) {
+        uint8_t s[32];
+        randomScalars(s, 32, seed);
+        if (i==1) memset(s, 0, 32);
+        if (i==2) memset(s, 0xFF, 32);
+        if (i==3) { mpz_sub_ui(k, r, 1); memset(s, 0, 32); mpz_export(s, NULL, -1, 1, 0, 0, k); }
+        if (i==4) memcpy(s, sl, 32);
+
+        uint8_t h1[GLV_HALF_SIZE], h2[GLV_HALF_SIZE];
+        bool neg1, neg2;
+        G1Glv.decompose(h1, neg1, h2, neg2, s, 32);
+        mpz_import(k, 32, -1, 1, 0, 0, s);
+        mpz_import(k1, GLV_HALF_SIZE, -1, 1, 0, 0, h1);
+        mpz_import(k2, GLV_HALF_SIZE, -1, 1, 0, 0, h2);
+        ASSERT_LT(mpz_sizeinbase(k1, 2), 128);
+        ASSERT_LT(mpz_sizeinbase(k2, 2), 128);
+        if (neg1) mpz_neg(k1, k1);
+        if (neg2) mpz_neg(k2, k2);
+        mpz_addmul(k1, k2, l);
+        mpz_sub(k1, k1, k);
+        ASSERT_TRUE(mpz_divisible_p(k1, r)) << i;
+
+        if (i<20) {
+            G1.mulByScalar(p1, G1.one(), s, 32);
+            G1Glv.mulByScalar(p2, G1.one(), s, 32);
+            ASSERT_TRUE(G1.eq(p1, p2)) << i;
+            G1Glv.mulByScalar(p2, G1.oneAffine(), s, 32);
+            ASSERT_TRUE(G1.eq(p1, p2)) << i;
+            G1.mulByScalar(p1, G1.one(), s, 8);
+            G1Glv.mulByScalar(p2, G1.oneAffine(), s, 8);
+            ASSERT_TRUE(G1.eq(p1, p2)) << i;
+        }
+    }
+    mpz_clears(k, k1, k2, l, r, NULL);
+}
+
+TEST(altBn128, g1_glvMultiExp) {
+    int N = 3000;
+
+    typedef uint8_t Scalar[32];
+    Scalar *scalars = new Scalar[N];
+    G1PointAffine *bases = new G1PointAffine[N];
+
+    G1.copy(bases[0], G1.one());
+    G1.copy(bases[1], G1.one());
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (int i=0; i<N; i++) {
+        if (i>1) G1.add(bases[i], bases[i-1], bases[i-2]);
+        randomScalars(scalars[i], 32, seed);
+        scalars[i][31] &= 0x1F;
+    }
+    G1.copy(bases[7], G1.zeroAffine());
+    for (int j=0; j<32; j++) scalars[5][j] = scalars[4][j];
+    G1.copy(bases[5], bases[4]);
+
+    G1Point p1, p2;
+    G1.multiMulByScalar(p1, bases, (uint8_t *)scalars, 32, N);
+    G1Glv.multiMulByScalar(p2, bases, (uint8_t *)scalars, 32, N);
+    ASSERT_TRUE(G1.eq(p1, p2));
+    G1Glv.multiMulByScalarBa(p2, bases, (uint8_t *)scalars, 32, N);
+    ASSERT_TRUE(G1.eq(p1, p2));
+
+    delete[] bases;
+    delete[] scalars;
+}
+
+TEST(altBn128, fq_fusedOps) {
+    int N = 8;
+    F1Element v[N];
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(v[i], 7*i+3);
+        F1.square(v[i], v[i]);
+        F1.square(v[i], v[i]);
+    }
+    F1.copy(v[0], F1.negOne());
+    F1.copy(v[1], F1.zero());
+
+    F1Element r, aux1, aux2;
+    for (int i=0; i<N; i++) {
+        const F1Element &a = v[i], &b = v[(i+1)%N], &c = v[(i+3)%N], &d = v[(i+6)%N];
+
+        F1.mulAdd(r, a, b, c);
+        F1.mul(aux1, a, b);
+        F1.add(aux1, aux1, c);
+        ASSERT_TRUE(F1.eq(r, aux1));
+
+        F1.mulSub(r, a, b, c);
+        F1.mul(aux1, a, b);
+        F1.sub(aux1, aux1, c);
+        ASSERT_TRUE(F1.eq(r, aux1));
+
+        F1.mulAddMul(r, a, b, c, d);
+        F1.mul(aux1, a, b);
+        F1.mul(aux2, c, d);
+        F1.add(aux1, aux1, aux2);
+        ASSERT_TRUE(F1.eq(r, aux1));
+
+        F1.mulSubMul(r, a, b, c, d);
+        F1.mul(aux1, a, b);
+        F1.mul(aux2, c, d);
+        F1.sub(aux1, aux1, aux2);
+        ASSERT_TRUE(F1.eq(r, aux1));
+    }
+
+    F1.copy(r, v[0]);
+    F1.mulSubMul(r, r, r, r, r);
+    ASSERT_TRUE(F1.isZero(r));
+}
+
+TEST(altBn128, f2_kernels) {
+    int N = 8;
+    F2Element v[N];
+
+    for (int i=0; i<N; i++) {
+        F1.fromUI(v[i].a, 5*i+1);
+        F1.square(v[i].a, v[i].a);
+        F1.square(v[i].a, v[i].a);
+        F1.square(v[i].b, v[i].a);
+    }
+    F2.copy(v[0], F2.negOne());
+    F1.copy(v[1].a, F1.negOne());
+    F1.copy(v[1].b, F1.negOne());
+    F1.copy(v[2].a, F1.zero());
+
+    // The products by nr = -1 with the base field
+    F2Element r, aux;
+    F1Element t;
+    for (int i=0; i<N; i++) {
+        const F2Element &a = v[i], &b = v[(i+3)%N];
+
+        F2.mul(r, a, b);
+        F1.mulSubMul(aux.a, a.a, b.a, a.b, b.b);
+        F1.mulAddMul(aux.b, a.a, b.b, a.b, b.a);
+        ASSERT_TRUE(F2.eq(r, aux));
+
+        F2.square(r, a);
+        F2.mul(aux, a, a);
+        ASSERT_TRUE(F2.eq(r, aux));
+
+        F2.inv(r, a);
+        F2.mul(aux, r, a);
+        ASSERT_TRUE(F2.eq(aux, F2.one()));
+
+        F2.copy(r, a);
+        F2.mul(r, r, r);
+        F2.square(aux, a);
+        ASSERT_TRUE(F2.eq(r, aux));
+    }
+
+    // A non residue without kernels
+    F2Field<RawFq> F2b("3");
+    for (int i=0; i<N; i++) {
+        const F2Element &a = v[i], &b = v[(i+5)%N];
+
+        F2b.mul(r, a, b);
+        F1.fromUI(t, 3);
+        F1.mul(t, t, b.b);
+        F1.mulAddMul(aux.a, a.a, b.a, a.b, t);
+        F1.mulAddMul(aux.b, a.a, b.b, a.b, b.a);
+        ASSERT_TRUE(F2b.eq(r, aux));
+
+        F2b.square(r, a);
+        F2b.mul(aux, a, a);
+        ASSERT_TRUE(F2b.eq(r, aux));
+    }
+}
+
+TEST(altBn128, f2_batchInverse) {
+    int N = 100;
+    F2Element a[N], r[N], aux;
+
+    F1.fromUI(a[0].a, 3);
+    F1.fromUI(a[0].b, 7);
+    for (int i=1; i<N; i++) {
+        F2.square(a[i], a[i-1]);
+        F2.add(a[i], a[i], F2.one());
+    }
+    F1.copy(a[1].b, F1.zero());
+    F1.copy(a[2].a, F1.zero());
+
+    F2.batchInverse(r, a, N);
+    for (int i=0; i<N; i++) {
+        F2.inv(aux, a[i]);
+        ASSERT_TRUE(F2.eq(r[i], aux)) << i;
+    }
+
+    // In place and with a nr without kernels
+    F2Field<RawFq> F2b("3");
+    F1Element scratch[2*N];
+    for (int i=0; i<N; i++) F2.copy(r[i], a[i]);
+    F2b.batchInverse(a, a, N, scratch);
+    for (int i=0; i<N; i++) {
+        F2b.mul(aux, a[i], r[i]);
+        ASSERT_TRUE(F2b.eq(aux, F2b.one())) << i;
+    }
+}
+
+TEST(altBn128, fq_inv) {
+    F1Element a, r, aux;
+
+    F1.inv(r, F1.one());
+    ASSERT_TRUE(F1.eq(r, F1.one()));
+
+    F1.inv(r, F1.negOne());
+    ASSERT_TRUE(F1.eq(r, F1.negOne()));
+
+    F1.inv(r, F1.zero());
+    ASSERT_TRUE(F1.isZero(r));
+
+    F1.fromUI(a, 5);
+    for (int i=0; i<100; i++) {
+        F1.inv(r, a);
+        F1.mul(aux, r, a);
+        ASSERT_TRUE(F1.eq(aux, F1.one()));
+        F1.square(a, a);
+        F1.add(a, a, F1.one());
+    }
+}
+
+TEST(altBn128, fixedExponents) {
+    F1Element a, a2, r, aux;
+    AltBn128::FrElement b, b2, rb, auxb;
+
+    // Fq is 3 mod 4 and Fr uses Tonelli-Shanks
+    ASSERT_EQ(F1.legendre(F1.zero()), 0);
+    ASSERT_EQ(Fr.legendre(Fr.zero()), 0);
+    ASSERT_TRUE(F1.sqrt(r, F1.zero()));
+    ASSERT_TRUE(F1.isZero(r));
+    ASSERT_TRUE(Fr.sqrt(rb, Fr.zero()));
+    ASSERT_TRUE(Fr.isZero(rb));
+
+    F1.fromUI(a, 5);
+    Fr.fromUI(b, 5);
+    for (int i=0; i<50; i++) {
+        F1.powQm2(r, a);
+        F1.mul(aux, r, a);
+        ASSERT_TRUE(F1.eq(aux, F1.one()));
+        Fr.powQm2(rb, b);
+        Fr.mul(auxb, rb, b);
+        ASSERT_TRUE(Fr.eq(auxb, Fr.one()));
+
+        F1.square(a2, a);
+        ASSERT_EQ(F1.legendre(a2), 1);
+        ASSERT_TRUE(F1.sqrt(r, a2));
+        F1.square(aux, r);
+        ASSERT_TRUE(F1.eq(aux, a2));
+        F1.neg(a2, a2);
+        ASSERT_EQ(F1.legendre(a2), -1);
+        ASSERT_FALSE(F1.sqrt(r, a2));
+
+        Fr.square(b2, b);
+        ASSERT_EQ(Fr.legendre(b2), 1);
+        ASSERT_TRUE(Fr.sqrt(rb, b2));
+        Fr.square(auxb, rb);
+        ASSERT_TRUE(Fr.eq(auxb, b2));
+        // 5 is not a square in Fr
+        Fr.mul(b2, b2, Fr.set(5));
+        ASSERT_EQ(Fr.legendre(b2), -1);
+        ASSERT_FALSE(Fr.sqrt(rb, b2));
+
+        F1.add(a, a, F1.one());
+        F1.square(a, a);
+        Fr.add(b, b, Fr.one());
+        Fr.square(b, b);
+    }
+}
+
+TEST(altBn128, lazyField) {
+#if defined(Fq_HAS_LAZY) && defined(Fr_HAS_LAZY)
+    RawFqLazy &FL = RawFqLazy::field;
+    F2Field<RawFqLazy> F2L("-1");
+    Curve<RawFqLazy> G1L(FL, "0", "3", "1", "2");
+    Curve< F2Field<RawFqLazy> > G2L(
+        F2L,
+        "0,0",
+        "19485874751759354771024239261021720505790618469301721065564631296452457478373, 266929791119991161246907387137283842545076965332900288569378510910307636690",
+        "10857046999023057135944570762232829481370756359578518086990519993285655852781, 11559732032986387107991004021392285783925812861821192530917403151452391805634",
+        "8495653923123431417604973247489272438418190587263600148770280649306958101930, 4082367875863433681332203403145435568316851327593401208105741076214120093531"
+    );
+
+    int N = 16;
+    F1Element v[N], lv[N];
+    for (int i=0; i<N; i++) {
+        F1.fromUI(v[i], 5*i+1);
+        F1.copy(lv[i], v[i]);
+    }
+    F1.copy(v[0], F1.zero());
+    F1.copy(lv[0], F1.zero());
+    for (int k=0; k<1000; k++) {
+        int i = k%N, j = (k*7+1)%N, l = (k*3+2)%N;
+        switch (k%5) {
+            case 0: F1.add(v[i], v[j], v[l]); FL.add(lv[i], lv[j], lv[l]); break;
+            case 1: F1.sub(v[i], v[j], v[l]); FL.sub(lv[i], lv[j], lv[l]); break;
+            case 2: F1.mul(v[i], v[j], v[l]); FL.mul(lv[i], lv[j], lv[l]); break;
+            case 3: F1.neg(v[i], v[j]); FL.neg(lv[i], lv[j]); break;
+            case 4: F1.mulSubMul(v[i], v[j], v[l], v[i], v[j]); FL.mulSubMul(lv[i], lv[j], lv[l], lv[i], lv[j]); break;
+        }
+        ASSERT_TRUE(FL.eq(lv[i], v[i]));
+        ASSERT_EQ(FL.isZero(lv[i]), F1.isZero(v[i]));
+        ASSERT_EQ(FL.toString(lv[i]), F1.toString(v[i]));
+    }
+    F1Element c;
+    FL.sub(c, FL.one(), FL.one());
+    ASSERT_TRUE(FL.isZero(c));
+
+    // Curves over the lazy field
+    uint8_t scalar[32];
+    mpz_t e;
+    mpz_init_set_str(e, "21888242871839275222246405745257275088548364400416034343698204186575808495617", 10);
+    for (int i=0;i<32;i++) scalar[i] = 0;
+    mpz_export((void *)scalar, NULL, -1, 8, -1, 0, e);
+    mpz_clear(e);
+
+    Curve<RawFqLazy>::Point p1;
+    G1L.mulByScalar(p1, G1L.one(), scalar, 32);
+    ASSERT_TRUE(G1L.isZero(p1));
+    Curve< F2Field<RawFqLazy> >::Point p2;
+    G2L.mulByScalar(p2, G2L.one(), scalar, 32);
+    ASSERT_TRUE(G2L.isZero(p2));
+
+    uint8_t scalar65 = 65;
+    G1Point q1;
+    G1.mulByScalar(q1, G1.one(), &scalar65, 1);
+    G1L.mulByScalar(p1, G1L.one(), &scalar65, 1);
+    ASSERT_EQ(G1L.toString(p1), G1.toString(q1));
+
+    // FFT over the lazy field
+    int NFFT = 1<<8;
+    AltBn128::FrElement *a = new AltBn128::FrElement[NFFT];
+    for (int i=0; i<NFFT; i++) Fr.fromUI(a[i], i+1);
+    FFT<RawFrLazy> fft(NFFT);
+    fft.fft(a, NFFT);
+    fft.ifft(a, NFFT);
+    AltBn128::FrElement aux;
+    for (int i=0; i<NFFT; i++) {
+        Fr.fromUI(aux, i+1);
+        ASSERT_TRUE(RawFrLazy::field.eq(a[i], aux));
+    }
+    delete[] a;
+#endif
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
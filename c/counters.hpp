@@ -0,0 +1,92 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Operation counters of each thread. Counters is a struct of uint64_t. Every thread counts
+// in its own slot, alone in a cache line, so counting does not make the cores fight for
+// the same line; total() adds up the slots of all the threads. The slots of finished
+// threads are reused by new ones and keep their counts. There is a registry per Owner.
+template <typename Owner, typename Counters>
+class ThreadCounters {
+
+    struct Slot {
+        alignas(64) Counters counters;
+        bool inUse;
+    };
+
+    // Frees the slot of the thread when it finishes
+    struct SlotOwner {
+        Slot *slot = NULL;
+        ~SlotOwner() {
+            std::lock_guard<std::mutex> guard(lock());
+            if (slot) slot->inUse = false;
+        }
+    };
+
+    static std::mutex &lock() {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::vector<Slot *> &slots() {
+        static std::vector<Slot *> s;
+        return s;
+    }
+
+    static Counters *registerThread() {
+        static thread_local SlotOwner owner;
+        std::lock_guard<std::mutex> guard(lock());
+        Slot *slot = NULL;
+        for (auto s : slots()) {
+            if (!s->inUse) {
+                slot = s;
+                break;
+            }
+        }
+        if (!slot) {
+            void *p;
+            if (posix_memalign(&p, 64, sizeof(Slot))) throw std::bad_alloc();
+            slot = (Slot *)p;
+            memset(slot, 0, sizeof(Slot));
+            slots().push_back(slot);
+        }
+        slot->inUse = true;
+        owner.slot = slot;
+        return &slot->counters;
+    }
+
+public:
+
+    static inline Counters &local() {
+        static thread_local Counters *c = NULL;
+        if (!c) c = registerThread();
+        return *c;
+    }
+
+    static Counters total() {
+        static_assert(sizeof(Counters) % sizeof(uint64_t) == 0, "Counters must be a struct of uint64_t");
+        Counters r;
+        uint64_t *dst = (uint64_t *)&r;
+        memset(&r, 0, sizeof(r));
+        std::lock_guard<std::mutex> guard(lock());
+        for (auto s : slots()) {
+            const uint64_t *src = (const uint64_t *)&s->counters;
+            for (size_t i=0; i<sizeof(Counters) / sizeof(uint64_t); i++) dst[i] += src[i];
+        }
+        return r;
+    }
+
+    // Should not run while other threads are counting
+    static void reset() {
+        std::lock_guard<std::mutex> guard(lock());
+        for (auto s : slots()) memset(&s->counters, 0, sizeof(Counters));
+    }
+};
+
+#endif // COUNTERS_H
@@ -1,3 +1,4 @@
+#include <vector>
 #include <sstream>
 
 template <typename BaseField>
@@ -51,10 +52,6 @@ void Curve<BaseField>::initCurve(typename BaseField::Element &aa, typename BaseF
         typeOfA = a_is_long;
     }
 
-#ifdef COUNT_OPS
-    resetCounters();
-#endif // COUNT_OPS
-
 }
 
 template <typename BaseField>
@@ -88,7 +85,7 @@ void inline Curve<BaseField>::mulByA(typename BaseField::Element &r, const typen
 template <typename BaseField>
 void Curve<BaseField>::add(Point &p3, const Point &p1, const Point &p2) {
 #ifdef COUNT_OPS
-    cntAdd++;
+    counters().cntAdd++;
 #endif // COUNT_OPS
 
     if (isZero(p1)) {
@@ -142,16 +139,13 @@ void Curve<BaseField>::add(Point &p3, const Point &p1, const Point &p2) {
     F.mul(Q, U1, PP);
 
     // X3 = R^2-PPP-2*Q
-    F.square(p3.x, R);
-    F.sub(p3.x, p3.x, PPP);
+    F.mulSub(p3.x, R, R, PPP);
     F.sub(p3.x, p3.x, Q);
     F.sub(p3.x, p3.x, Q);
 
     // Y3 = R*(Q-X3)-S1*PPP
-    F.mul(tmp, S1, PPP);
-    F.sub(p3.y, Q, p3.x);
-    F.mul(p3.y, p3.y, R );
-    F.sub(p3.y, p3.y, tmp);
+    F.sub(tmp, Q, p3.x);
+    F.mulSubMul(p3.y, tmp, R, S1, PPP);
 
     // ZZ3 = ZZ1*ZZ2*PP
     F.mul(p3.zz, p1.zz, p2.zz);
@@ -182,7 +176,7 @@ void Curve<BaseField>::add(Point &p3, const Point &p1, const Point &p2) {
 template <typename BaseField>
 void Curve<BaseField>::add(Point &p3, const Point &p1, const PointAffine &p2) {
 #ifdef COUNT_OPS
-    cntAddMixed++;
+    counters().cntAddMixed++;
 #endif // COUNT_OPS
 
 
@@ -229,16 +223,13 @@ void Curve<BaseField>::add(Point &p3, const Point &p1, const PointAffine &p2) {
     F.mul(Q, p1.x, PP);
 
     // X3 = R^2-PPP-2*Q
-    F.square(p3.x, R);
-    F.sub(p3.x, p3.x, PPP);
+    F.mulSub(p3.x, R, R, PPP);
     F.sub(p3.x, p3.x, Q);
     F.sub(p3.x, p3.x, Q);
 
     // Y3 = R*(Q-X3)-Y1*PPP
-    F.mul(tmp, p1.y, PPP);
-    F.sub(p3.y, Q, p3.x);
-    F.mul(p3.y, p3.y, R );
-    F.sub(p3.y, p3.y, tmp);
+    F.sub(tmp, Q, p3.x);
+    F.mulSubMul(p3.y, tmp, R, p1.y, PPP);
 
     // ZZ3 = ZZ1*PP
     F.mul(p3.zz, p1.zz, PP);
@@ -263,7 +254,7 @@ void Curve<BaseField>::add(Point &p3, const Point &p1, const PointAffine &p2) {
 template <typename BaseField>
 void Curve<BaseField>::add(Point &p3, const PointAffine &p1, const PointAffine &p2) {
 #ifdef COUNT_OPS
-    cntAddAffine++;
+    counters().cntAddAffine++;
 #endif // COUNT_OPS
 
     if (isZero(p1)) {
@@ -301,16 +292,13 @@ void Curve<BaseField>::add(Point &p3, const PointAffine &p1, const PointAffine &
     F.mul(Q, p1.x, PP);
 
     // X3 = R^2-PPP-2*Q
-    F.square(p3.x, R);
-    F.sub(p3.x, p3.x, PPP);
+    F.mulSub(p3.x, R, R, PPP);
     F.sub(p3.x, p3.x, Q);
     F.sub(p3.x, p3.x, Q);
 
     // Y3 = R*(Q-X3)-Y1*PPP
-    F.mul(tmp, p1.y, PPP);
-    F.sub(p3.y, Q, p3.x);
-    F.mul(p3.y, p3.y, R );
-    F.sub(p3.y, p3.y, tmp);
+    F.sub(tmp, Q, p3.x);
+    F.mulSubMul(p3.y, tmp, R, p1.y, PPP);
 
     // ZZ3 = PP
     F.copy(p3.zz, PP);
@@ -337,7 +325,7 @@ void Curve<BaseField>::add(Point &p3, const PointAffine &p1, const PointAffine &
 template <typename BaseField>
 void Curve<BaseField>::dbl(Point &p3, const Point &p1) {
 #ifdef COUNT_OPS
-    cntDbl++;
+    counters().cntDbl++;
 #endif // COUNT_OPS
 
 
@@ -376,15 +364,12 @@ void Curve<BaseField>::dbl(Point &p3, const Point &p1) {
     }
 
     // X3 = M^2-2*S
-    F.square(p3.x, M);
-    F.sub(p3.x, p3.x, S);
+    F.mulSub(p3.x, M, M, S);
     F.sub(p3.x, p3.x, S);
 
     // Y3 = M*(S-X3)-W*Y1
-    F.mul(tmp, W, p1.y);
-    F.sub(p3.y, S, p3.x);
-    F.mul(p3.y, M, p3.y);
-    F.sub(p3.y, p3.y, tmp);
+    F.sub(tmp, S, p3.x);
+    F.mulSubMul(p3.y, M, tmp, W, p1.y);
 
     // ZZ3 = V*ZZ1
     F.mul(p3.zz, V, p1.zz);
@@ -408,7 +393,7 @@ void Curve<BaseField>::dbl(Point &p3, const Point &p1) {
 template <typename BaseField>
 void Curve<BaseField>::dbl(Point &p3, const PointAffine &p1) {
 #ifdef COUNT_OPS
-    cntDblMixed++;
+    counters().cntDblMixed++;
 #endif // COUNT_OPS
 
     if (isZero(p1)) {
@@ -440,15 +425,12 @@ void Curve<BaseField>::dbl(Point &p3, const PointAffine &p1) {
     F.add(M, M, fa);
 
     // X3 = M^2-2*S
-    F.square(p3.x, M);
-    F.sub(p3.x, p3.x, S);
+    F.mulSub(p3.x, M, M, S);
     F.sub(p3.x, p3.x, S);
 
     // Y3 = M*(S-X3)-W*Y1
-    F.mul(tmp, p3.zzz, p1.y);
-    F.sub(p3.y, S, p3.x);
-    F.mul(p3.y, M, p3.y);
-    F.sub(p3.y, p3.y, tmp);
+    F.sub(tmp, S, p3.x);
+    F.mulSubMul(p3.y, M, tmp, p3.zzz, p1.y);
 
     // ZZ3 = V ; Already stored
 
@@ -458,7 +440,7 @@ void Curve<BaseField>::dbl(Point &p3, const PointAffine &p1) {
 template <typename BaseField>
 bool Curve<BaseField>::eq(const Point &p1, const Point &p2) {
 #ifdef COUNT_OPS
-    cntEq++;
+    counters().cntEq++;
 #endif // COUNT_OPS
 
     if (isZero(p1)) return  isZero(p2);
@@ -494,7 +476,7 @@ bool Curve<BaseField>::eq(const Point &p1, const Point &p2) {
 template <typename BaseField>
 bool Curve<BaseField>::eq(const Point &p1, const PointAffine &p2) {
 #ifdef COUNT_OPS
-    cntEqMixed++;
+    counters().cntEqMixed++;
 #endif // COUNT_OPS
 
     if (isZero(p1)) return  isZero(p2);
@@ -562,7 +544,7 @@ void Curve<BaseField>::copy(Point &r, const PointAffine &a) {
 template <typename BaseField>
 void Curve<BaseField>::copy(PointAffine &r, const Point &a) {
 #ifdef COUNT_OPS
-    cntToAffine++;
+    counters().cntToAffine++;
 #endif // COUNT_OPS
     if (isZero(a)) {
         F.copy(r.x, F.zero());
@@ -579,6 +561,38 @@ void Curve<BaseField>::copy(PointAffine &r, const PointAffine &a) {
     F.copy(r.y, a.y);
 }
 
+// zz^3 = zzz^2, so 1/zz = (zz/zzz)^2 and only zzz is inverted
+template <typename BaseField>
+void Curve<BaseField>::batchToAffine(PointAffine *r, const Point *a, u_int64_t n) {
+#ifdef COUNT_OPS
+    counters().cntToAffine += n;
+#endif // COUNT_OPS
+    // Small batches, like the tables of wnafMulByScalar, stay on the stack and in the thread
+    typename BaseField::Element smallBuff[2*CURVE_SMALL_BATCH];
+    typename BaseField::Element *dens = n <= CURVE_SMALL_BATCH ? smallBuff : new typename BaseField::Element[2*n];
+    typename BaseField::Element *invs = dens + n;
+
+    #pragma omp parallel for if(n > CURVE_SMALL_BATCH)
+    for (int64_t i=0; i<(int64_t)n; i++) {
+        F.copy(dens[i], isZero(a[i]) ? F.one() : a[i].zzz);
+    }
+    F.batchInverse(invs, dens, n, NULL);
+
+    #pragma omp parallel for if(n > CURVE_SMALL_BATCH)
+    for (int64_t i=0; i<(int64_t)n; i++) {
+        if (isZero(a[i])) {
+            copy(r[i], fzeroAffine);
+            continue;
+        }
+        typename BaseField::Element t;
+        F.mul(t, a[i].zz, invs[i]);
+        F.square(t, t);
+        F.mul(r[i].x, a[i].x, t);
+        F.mul(r[i].y, a[i].y, invs[i]);
+    }
+    if (dens != smallBuff) delete[] dens;
+}
+
 template <typename BaseField>
 void Curve<BaseField>::neg(Point &r, const Point &a) {
     F.copy(r.x, a.x);
@@ -598,7 +612,7 @@ void Curve<BaseField>::neg(Point &r, const PointAffine &a) {
 template <typename BaseField>
 void Curve<BaseField>::neg(PointAffine &r, const Point &a) {
 #ifdef COUNT_OPS
-    cntToAffine++;
+    counters().cntToAffine++;
 #endif // COUNT_OPS
     if (isZero(a)) {
         F.copy(r.x, F.zero());
@@ -636,28 +650,22 @@ std::string Curve<BaseField>::toString(const PointAffine &p, uint32_t radix) {
 #ifdef COUNT_OPS
 template <typename BaseField>
 void Curve<BaseField>::resetCounters() {
-    cntAddMixed = 0;
-    cntAdd=0;
-    cntAddAffine=0;
-    cntDbl=0;
-    cntDblMixed=0;
-    cntEq=0;
-    cntEqMixed=0;
-    cntToAffine=0;
+    ThreadCounters<Curve<BaseField>, Counters>::reset();
 }
 
 template <typename BaseField>
 void Curve<BaseField>::printCounters() {
-    printf("cntAddMixed: %'d\n", cntAddMixed);
-    printf("cntAdd: %'d\n", cntAdd);
-    printf("cntAddAffine: %'d\n", cntAddAffine);
-    printf("cntAdd TOTAL: %'d\n", cntAddMixed + cntAdd+ cntAddAffine);
-    printf("cntDbl: %'d\n", cntDbl);
-    printf("cntDblMixed: %'d\n", cntDblMixed);
-    printf("cntDbl TOTAL: %'d\n", cntDbl + cntDblMixed);
-    printf("cntEq: %'d\n", cntEq);
-    printf("cntEqMixed: %'d\n", cntEqMixed);
-    printf("cntToAffine: %'d\n", cntToAffine);    
+    Counters c = getCounters();
+    printf("cntAddMixed: %'lu\n", c.cntAddMixed);
+    printf("cntAdd: %'lu\n", c.cntAdd);
+    printf("cntAddAffine: %'lu\n", c.cntAddAffine);
+    printf("cntAdd TOTAL: %'lu\n", c.cntAddMixed + c.cntAdd+ c.cntAddAffine);
+    printf("cntDbl: %'lu\n", c.cntDbl);
+    printf("cntDblMixed: %'lu\n", c.cntDblMixed);
+    printf("cntDbl TOTAL: %'lu\n", c.cntDbl + c.cntDblMixed);
+    printf("cntEq: %'lu\n", c.cntEq);
+    printf("cntEqMixed: %'lu\n", c.cntEqMixed);
+    printf("cntToAffine: %'lu\n", c.cntToAffine);    
 }
 #endif // COUNT_OPS
 
@@ -666,7 +674,13 @@ void Curve<BaseField>::multiAdd(PointAffine *p3, const PointAffine *p1, const Po
 {
 //    const auto p3AlreadyCalculated = -1;
 //    int64_t *eqs = new int64_t [count];
-    typename BaseField::Element *lambdas = (typename BaseField::Element *)malloc(sizeof(typename BaseField::Element) * count);
+    // The denominators and their inverses live in a buffer of each thread that is reused
+    // between calls. The inverses are written to another half, so batchInverse does not
+    // need scratch.
+    static thread_local std::vector<typename BaseField::Element> scratch;
+    if (scratch.size() < 2 * count) scratch.resize(2 * count);
+    typename BaseField::Element *dens = scratch.data();
+    typename BaseField::Element *lambdas = dens + count;
     u_int64_t lambdaIndex = 0;
 
     for (auto index = 0; index < count; ++index) {
@@ -676,31 +690,27 @@ void Curve<BaseField>::multiAdd(PointAffine *p3, const PointAffine *p1, const Po
         __builtin_prefetch(lambdas + lambdaIndex + 8, 1); */
         auto &_p1 = p1[index];
         auto &_p2 = p2[index];
-        auto &_p3 = p3[index];
 //        auto &_eqs = eqs[index];
-        if (isZero(_p1)) {
-            copy(_p3, _p2);
-//            eqs[index] = p3AlreadyCalculated;
-            continue;
-        }
-        if (isZero(_p2)) {
-            copy(_p3, _p1);
+        // The results are only written in the second loop, so p3 can be p1 or p2
+        if (isZero(_p1) || isZero(_p2)) {
 //            eqs[index] = p3AlreadyCalculated;
             continue;
         }
 /*        eqs[index] = F.eq(p1[index].x, p2[index].x) && F.eq(p1[index].y, p2[index].y);
         if (eqs[index]) {*/
-        if (F.eq(_p1.x, _p2.x) && F.eq(_p1.y, _p2.y)) {
-            F.add(lambdas[lambdaIndex++], _p1.y, _p1.y);
+        if (F.eq(_p1.x, _p2.x)) {
+            // p2 = -p1, the denominator would be zero
+            if (!F.eq(_p1.y, _p2.y)) continue;
+            F.add(dens[lambdaIndex++], _p1.y, _p1.y);
         }
         else {
-            F.sub(lambdas[lambdaIndex++], _p2.x, _p1.x);
+            F.sub(dens[lambdaIndex++], _p2.x, _p1.x);
         }
         // F.copy(lambdas[lambdaIndex++], _eqs ? F.add(_p1.y, _p1.y) : F.sub(_p2.x,_p1.x));
     }
 
     auto lambdaCount = lambdaIndex;
-    F.batchInverse_2(lambdas, lambdas, lambdaCount);
+    F.batchInverse(lambdas, dens, lambdaCount, NULL);
     lambdaIndex = 0;
     for (auto index = 0; index < count; ++index) {
         /* __builtin_prefetch(p1 + index + 8, 0);
@@ -714,9 +724,22 @@ void Curve<BaseField>::multiAdd(PointAffine *p3, const PointAffine *p1, const Po
         auto &_lambda = lambdas[lambdaIndex];
 
         // if (eqs[index] == p3AlreadyCalculated) continue;
+        // They have no lambda
+        if (isZero(_p1)) {
+            copy(_p3, _p2);
+            continue;
+        }
+        if (isZero(_p2)) {
+            copy(_p3, _p1);
+            continue;
+        }
 
 //        if (eqs[index]) {            
-        if (F.eq(_p1.x, _p2.x) && F.eq(_p1.y, _p2.y)) {
+        if (F.eq(_p1.x, _p2.x)) {
+            if (!F.eq(_p1.y, _p2.y)) {
+                copy(_p3, fzeroAffine);
+                continue;
+            }
             // l = l * (3 * p1.x**2) + a
             F.mul(_lambda, _lambda, F.add(F.mul(F.square(_p1.x), 3), fa));
         }
@@ -725,14 +748,116 @@ void Curve<BaseField>::multiAdd(PointAffine *p3, const PointAffine *p1, const Po
             F.mul(_lambda, _lambda, F.sub(_p2.y, _p1.y));
         }
 
-        // p3.x = l**2 - (p1.x + p2.x) 
-        F.sub(_p3.x, F.square(_lambda), F.add(_p1.x, _p2.x));
-
-        // p3.y = l * (p1.x - p3.x) - p1.y
-        F.sub(_p3.y, F.mul(_lambda, F.sub(_p1.x, _p3.x)), _p1.y);
+        // x3 = l**2 - (p1.x + p2.x), y3 = l * (p1.x - x3) - p1.y. p1 is read before p3
+        // is written, since p3 can be p1 or p2.
+        typename BaseField::Element x3, y3;
+        F.sub(x3, F.square(_lambda), F.add(_p1.x, _p2.x));
+        F.sub(y3, F.mul(_lambda, F.sub(_p1.x, x3)), _p1.y);
+        F.copy(_p3.x, x3);
+        F.copy(_p3.y, y3);
         
         ++lambdaIndex;
     }
 //    free(eqs);
-    free(lambdas);
+}
+
+template <typename BaseField>
+void Curve<BaseField>::multiDbl(PointAffine *r, const PointAffine *a, u_int64_t count)
+{
+    // Same buffers as multiAdd
+    static thread_local std::vector<typename BaseField::Element> scratch;
+    if (scratch.size() < 2 * count) scratch.resize(2 * count);
+    typename BaseField::Element *dens = scratch.data();
+    typename BaseField::Element *invs = dens + count;
+    u_int64_t nDens = 0;
+
+    for (u_int64_t i=0; i<count; i++) {
+        if (!isZero(a[i])) F.add(dens[nDens++], a[i].y, a[i].y);
+    }
+    if (nDens) F.batchInverse(invs, dens, nDens, NULL);
+
+    nDens = 0;
+    for (u_int64_t i=0; i<count; i++) {
+        if (isZero(a[i])) {
+            copy(r[i], fzeroAffine);
+            continue;
+        }
+        typename BaseField::Element l, x3, t;
+        // l = (3 * x**2 + a) / (2 * y)
+        F.square(t, a[i].x);
+        F.add(l, t, t);
+        F.add(l, l, t);
+        if (typeOfA != a_is_zero) F.add(l, l, fa);
+        F.mul(l, l, invs[nDens++]);
+        // x3 = l**2 - 2 * x, y3 = l * (x - x3) - y. r can be a.
+        F.square(x3, l);
+        F.sub(x3, x3, a[i].x);
+        F.sub(x3, x3, a[i].x);
+        F.sub(t, a[i].x, x3);
+        F.mul(t, l, t);
+        F.sub(r[i].y, t, a[i].y);
+        F.copy(r[i].x, x3);
+    }
+}
+
+// All the products advance together, one digit of the wNAFs per step, and each step
+// takes a multiDbl of all the points and a multiAdd of the ones with a digit: two batch
+// inversions per block and digit.
+template <typename BaseField>
+void Curve<BaseField>::batchMulByScalar(PointAffine *r, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, u_int64_t n) {
+    const unsigned int w = wnafWidth(scalarSize);
+    const u_int64_t nOdd = 1 << (w-2);
+    const u_int64_t nDigits = scalarSize*8 + 1;
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int64_t from=0; from<(int64_t)n; from+=CURVE_BATCH_MUL_BLOCK) {
+        u_int64_t count = n-from < CURVE_BATCH_MUL_BLOCK ? n-from : CURVE_BATCH_MUL_BLOCK;
+
+        // odd multiples of the bases, nOdd arrays of count points, then acc, 2*base and
+        // the gathered operands of the additions
+        std::vector<PointAffine> buff((nOdd + 5) * count);
+        PointAffine *table = buff.data();
+        PointAffine *acc = table + nOdd*count;
+        PointAffine *base2 = acc + count;
+        PointAffine *left = base2 + count;
+        PointAffine *right = left + count;
+        PointAffine *sums = right + count;
+        std::vector<int8_t> naf(nDigits * count);
+        std::vector<u_int64_t> idx(count);
+
+        int len = 0;
+        for (u_int64_t i=0; i<count; i++) {
+            int l = buildWNaf(naf.data() + i*nDigits, scalars + (from+i)*scalarSize, scalarSize, w);
+            if (l > len) len = l;
+            copy(table[i], bases[from+i]); // r can be bases
+            copy(acc[i], fzeroAffine);
+        }
+        if (nOdd > 1) {
+            multiDbl(base2, table, count);
+            for (u_int64_t j=1; j<nOdd; j++) {
+                multiAdd(table + j*count, table + (j-1)*count, base2, count);
+            }
+        }
+
+        for (int d=len-1; d>=0; d--) {
+            if (d < len-1) multiDbl(acc, acc, count);
+            u_int64_t k = 0;
+            for (u_int64_t i=0; i<count; i++) {
+                int8_t digit = naf[i*nDigits + d];
+                if (!digit) continue;
+                copy(left[k], acc[i]);
+                if (digit > 0) {
+                    copy(right[k], table[(digit >> 1)*count + i]);
+                } else {
+                    neg(right[k], table[((-digit) >> 1)*count + i]);
+                }
+                idx[k++] = i;
+            }
+            if (!k) continue;
+            multiAdd(sums, left, right, k);
+            for (u_int64_t j=0; j<k; j++) copy(acc[idx[j]], sums[j]);
+        }
+
+        for (u_int64_t i=0; i<count; i++) copy(r[from+i], acc[i]);
+    }
 }
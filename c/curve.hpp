@@ -1,9 +1,15 @@
 #include <string>
 
 #include "exp.hpp"
+#include "counters.hpp"
 #include "multiexp.hpp"
 #include "multiexp_ba.hpp"
 
+// batchToAffine of up to this many points runs in the calling thread without allocating
+#define CURVE_SMALL_BATCH 64
+// Points of each thread in batchMulByScalar
+#define CURVE_BATCH_MUL_BLOCK 1024
+
 template <typename BaseField>
 class Curve {
 
@@ -41,14 +47,19 @@ private:
 public:
 
 #ifdef COUNT_OPS
-    int cntAddMixed;
-    int cntAdd;
-    int cntAddAffine;
-    int cntDbl;
-    int cntEq;
-    int cntEqMixed;    
-    int cntDblMixed;
-    int cntToAffine;
+    typedef struct {
+        uint64_t cntAddMixed;
+        uint64_t cntAdd;
+        uint64_t cntAddAffine;
+        uint64_t cntDbl;
+        uint64_t cntEq;
+        uint64_t cntEqMixed;
+        uint64_t cntDblMixed;
+        uint64_t cntToAffine;
+    } Counters;
+    // The counters of the calling thread. getCounters adds up all the threads.
+    static inline Counters &counters() { return ThreadCounters<Curve<BaseField>, Counters>::local(); }
+    Counters getCounters() { return ThreadCounters<Curve<BaseField>, Counters>::total(); }
 #endif // COUNT_OPS
 
 
@@ -68,7 +79,12 @@ public:
     void add(Point &p3, const Point &p1, const PointAffine &p2);
     void add(Point &p3, const PointAffine &p1, const PointAffine &p2);
     void add(Point &p3, const PointAffine &p1, const Point &p2) { add(p3, p2, p1); };
+    // p3[i] = p1[i] + p2[i] with one batch inversion. p3 can be p1 or p2.
     void multiAdd(PointAffine *p3, const PointAffine *p1, const PointAffine *p2, u_int64_t count);
+    // Doubles count affine points with one batch inversion. r can be a.
+    void multiDbl(PointAffine *r, const PointAffine *a, u_int64_t count);
+    // Converts n points to affine with a single batch inversion. Points at infinity give zeroAffine.
+    void batchToAffine(PointAffine *r, const Point *a, u_int64_t n);
 
     void add(PointAffine &p3, const Point &p1, const Point &p2) { Point tmp; add(tmp, p1, p2); copy(p3, tmp); };
     void add(PointAffine &p3, const Point &p1, const PointAffine &p2) { Point tmp; add(tmp, p1, p2); copy(p3, tmp); };
@@ -111,14 +127,18 @@ public:
     void copy(PointAffine &r, const Point &a);
     void copy(PointAffine &r, const PointAffine &a);
 
+    // The width of the wNAF is picked by the size of the scalar
     void mulByScalar(Point &r, const Point &base, const uint8_t *scalar, unsigned int scalarSize) {
-        nafMulByScalar<Curve<BaseField>, Point, Point>(*this, r, base, scalar, scalarSize);
+        wnafMulByScalar<Curve<BaseField>, Point>(*this, r, base, scalar, scalarSize, wnafWidth(scalarSize));
     }
 
     void mulByScalar(Point &r, const PointAffine &base, const uint8_t *scalar, unsigned int scalarSize) {
-        nafMulByScalar<Curve<BaseField>, PointAffine, Point>(*this, r, base, scalar, scalarSize);
+        wnafMulByScalar<Curve<BaseField>, PointAffine>(*this, r, base, scalar, scalarSize, wnafWidth(scalarSize));
     }
 
+    // r[i] = scalars[i] * bases[i] with affine additions and batch inversions. r can be bases.
+    void batchMulByScalar(PointAffine *r, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, u_int64_t n);
+
     void multiMulByScalar(Point &r, PointAffine *bases, uint8_t *scalars, unsigned int scalarSize, unsigned int n, unsigned int nThreads=0) {
         ParallelMultiexp<Curve<BaseField>> pm(*this);
         pm.multiexp(r, bases, scalars, scalarSize, n);
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <iostream>
+#include <stdexcept>
 
 #include "naf.hpp"
 
@@ -27,3 +28,64 @@ void nafMulByScalar(BaseGroup &G, BaseGroupElementOut& r, const BaseGroupElement
     delete[] naf;
 }
 
+
+// Scalars up to this size are recoded on the stack
+#define WNAF_MAX_SCALAR_SIZE 64
+
+// Width of the wNAF of a scalar of scalarSize bytes. The table of 2^(w-2) odd multiples
+// has to be paid by the additions it saves.
+inline unsigned int wnafWidth(unsigned int scalarSize) {
+    if (scalarSize <= 8) return 2;
+    if (scalarSize <= 16) return 4;
+    if (scalarSize <= 64) return 5;
+    return 6;
+}
+
+// The odd multiples of the base are converted to affine with one batch inversion, so the
+// additions of the main loop are mixed. Width 2 is the NAF and takes no table.
+template <typename BaseGroup, typename BaseGroupElementIn>
+void wnafMulByScalar(BaseGroup &G, typename BaseGroup::Point& r, const BaseGroupElementIn& base, const uint8_t* scalar, unsigned int scalarSize, unsigned int w) {
+    // The table of odd multiples is on the stack
+    if ((w < 2) || (w > WNAF_MAX_WIDTH)) {
+        throw std::invalid_argument("Invalid wNAF width");
+    }
+    int8_t nafBuff[WNAF_MAX_SCALAR_SIZE*8+1];
+    int8_t *naf = scalarSize <= WNAF_MAX_SCALAR_SIZE ? nafBuff : new int8_t[scalarSize*8+1];
+    int i = buildWNaf(naf, scalar, scalarSize, w) - 1;
+
+    if (w <= 2) {
+        BaseGroupElementIn baseCopy;
+        G.copy(baseCopy, base); // base and result can be the same
+        G.copy(r, G.zero());
+        for (; i>=0; i--) {
+            G.dbl(r, r);
+            if (naf[i] > 0) {
+                G.add(r, r, baseCopy);
+            } else if (naf[i] < 0) {
+                G.sub(r, r, baseCopy);
+            }
+        }
+    } else {
+        // base, 3*base, 5*base ...
+        const int nOdd = 1 << (w-2);
+        typename BaseGroup::Point odd[1 << (WNAF_MAX_WIDTH-2)];
+        typename BaseGroup::PointAffine table[1 << (WNAF_MAX_WIDTH-2)];
+        typename BaseGroup::Point base2;
+        G.copy(odd[0], base);
+        G.dbl(base2, odd[0]);
+        for (int j=1; j<nOdd; j++) G.add(odd[j], odd[j-1], base2);
+        G.batchToAffine(table, odd, nOdd);
+
+        G.copy(r, G.zero());
+        for (; i>=0; i--) {
+            G.dbl(r, r);
+            if (naf[i] > 0) {
+                G.add(r, r, table[naf[i] >> 1]);
+            } else if (naf[i] < 0) {
+                G.sub(r, r, table[(-naf[i]) >> 1]);
+            }
+        }
+    }
+
+    if (naf != nafBuff) delete[] naf;
+}
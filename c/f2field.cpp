@@ -1,9 +1,10 @@
 #include "splitparstr.hpp"
 #include "assert.h"
 #include <sstream>
+#include <vector>
 
 template <typename BaseField>
-F2Field<BaseField>::F2Field(typename BaseField::Element &anr) {
+F2Field<BaseField>::F2Field(const typename BaseField::Element &anr) {
     initField(anr);
 }
 
@@ -18,7 +19,7 @@ F2Field<BaseField>::F2Field(std::string nrs) {
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::initField(typename BaseField::Element &anr) {
+void F2Field<BaseField>::initField(const typename BaseField::Element &anr) {
     F.copy(nr, anr);
     F.copy(fZero.a, F.zero());
     F.copy(fZero.b, F.zero());
@@ -36,6 +37,8 @@ void F2Field<BaseField>::initField(typename BaseField::Element &anr) {
     } else {
         typeOfNr = nr_is_long;
     }
+
+    hasKernels = F2Kernels<BaseField>::match(F, nr);
 }
 
 
@@ -50,14 +53,14 @@ void F2Field<BaseField>::fromString(Element &r, std::string s) {
 }
 
 template <typename BaseField>
-std::string F2Field<BaseField>::toString(Element &e, uint32_t radix) {
+std::string F2Field<BaseField>::toString(const Element &e, uint32_t radix) {
     std::ostringstream stringStream;
     stringStream << "(" << F.toString(e.a, radix) << "," << F.toString(e.b, radix) << ")";
     return stringStream.str();
 }
 
 template <typename BaseField>
-void inline F2Field<BaseField>::mulByNr(typename BaseField::Element &r, typename BaseField::Element &a) {
+void inline F2Field<BaseField>::mulByNr(typename BaseField::Element &r, const typename BaseField::Element &a) {
     switch (typeOfNr) {
         case nr_is_zero: F.copy(r, F.zero()); break;
         case nr_is_one: F.copy(r, a); break;
@@ -67,52 +70,93 @@ void inline F2Field<BaseField>::mulByNr(typename BaseField::Element &r, typename
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::add(Element &r, Element &a, Element &b) {
+void F2Field<BaseField>::norm(typename BaseField::Element &r, const Element &a) {
+    typename BaseField::Element tmp;
+    switch (typeOfNr) {
+        case nr_is_zero: F.square(r, a.a); break;
+        case nr_is_one: F.mulSubMul(r, a.a, a.a, a.b, a.b); break;
+        case nr_is_negone: F.mulAddMul(r, a.a, a.a, a.b, a.b); break;
+        case nr_is_long:
+            F.mul(tmp, nr, a.b);
+            F.mulSubMul(r, a.a, a.a, tmp, a.b);
+    }
+}
+
+template <typename BaseField>
+typename F2Field<BaseField>::Element F2Field<BaseField>::set(int value) {
+    Element r;
+    F.set(r.a, value);
+    F.copy(r.b, F.zero());
+    return r;
+}
+
+template <typename BaseField>
+typename F2Field<BaseField>::Element F2Field<BaseField>::mul(const Element &a, int b) {
+    Element r;
+    typename BaseField::Element k;
+    F.set(k, b);
+    F.mul(r.a, a.a, k);
+    F.mul(r.b, a.b, k);
+    return r;
+}
+
+template <typename BaseField>
+void F2Field<BaseField>::add(Element &r, const Element &a, const Element &b) {
     F.add(r.a, a.a, b.a);
     F.add(r.b, a.b, b.b);
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::sub(Element &r, Element &a, Element &b) {
+void F2Field<BaseField>::sub(Element &r, const Element &a, const Element &b) {
     F.sub(r.a, a.a, b.a);
     F.sub(r.b, a.b, b.b);
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::neg(Element &r, Element &a) {
+void F2Field<BaseField>::neg(Element &r, const Element &a) {
     F.neg(r.a, a.a);
     F.neg(r.b, a.b);
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::copy(Element &r, Element &a) {
+void F2Field<BaseField>::copy(Element &r, const Element &a) {
     F.copy(r.a, a.a);
     F.copy(r.b, a.b);
 }
 
+// (a0 + a1*u)*(b0 + b1*u) = (a0*b0 + nr*a1*b1) + (a0*b1 + a1*b0)*u
+// Each component is a sum of two products computed with a single reduction,
+// which is cheaper than the three reductions of Karatsuba.
 template <typename BaseField>
-void F2Field<BaseField>::mul(Element &r, Element &e1, Element &e2) {
-    typename BaseField::Element aa;
-    F.mul(aa, e1.a, e2.a);
-    typename BaseField::Element bb;
-    F.mul(bb, e1.b, e2.b);
-
-    typename BaseField::Element bbr;
-    mulByNr(bbr, bb);
+void F2Field<BaseField>::mul(Element &r, const Element &e1, const Element &e2) {
+    if (hasKernels) {
+        F2Kernels<BaseField>::mul(F, r, e1, e2);
+        return;
+    }
 
-    typename BaseField::Element sum1, sum2;
-    F.add(sum1, e1.a, e1.b);
-    F.add(sum2, e2.a, e2.b);
+    typename BaseField::Element ra;
+    typename BaseField::Element tmp;
 
-    F.add(r.a, aa, bbr);
+    switch (typeOfNr) {
+        case nr_is_zero: F.mul(ra, e1.a, e2.a); break;
+        case nr_is_one: F.mulAddMul(ra, e1.a, e2.a, e1.b, e2.b); break;
+        case nr_is_negone: F.mulSubMul(ra, e1.a, e2.a, e1.b, e2.b); break;
+        case nr_is_long:
+            F.mul(tmp, nr, e2.b);
+            F.mulAddMul(ra, e1.a, e2.a, e1.b, tmp);
+    }
 
-    F.mul(r.b, sum1, sum2 );
-    F.sub(r.b, r.b, aa);
-    F.sub(r.b, r.b, bb);
+    F.mulAddMul(r.b, e1.a, e2.b, e1.b, e2.a);
+    F.copy(r.a, ra);
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::square(Element &r, Element &e1) {
+void F2Field<BaseField>::square(Element &r, const Element &e1) {
+    if (hasKernels) {
+        F2Kernels<BaseField>::square(F, r, e1);
+        return;
+    }
+
     typename BaseField::Element ab;
     typename BaseField::Element tmp1, tmp2;
 
@@ -129,7 +173,7 @@ void F2Field<BaseField>::square(Element &r, Element &e1) {
 
         F.add(tmp1, e1.a, e1.b);
         mulByNr(tmp2, e1.b);
-        F.add(tmp2, e1.a, tmp1);
+        F.add(tmp2, e1.a, tmp2);
 
         F.mul(tmp1, tmp1, tmp2);
 
@@ -142,31 +186,88 @@ void F2Field<BaseField>::square(Element &r, Element &e1) {
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::inv(Element &r, Element &e1) {
-    typename BaseField::Element t0, t1, t2, t3;
-    F.square(t0, e1.a);
-    F.square(t1, e1.b);
-    mulByNr(t2, t1);
-    F.sub(t2, t0, t2);
-    F.inv(t3, t2);
-    F.mul(r.a, e1.a, t3);
-    F.mul(r.b, e1.b, t3);
+void F2Field<BaseField>::inv(Element &r, const Element &e1) {
+    if (hasKernels) {
+        F2Kernels<BaseField>::inv(F, r, e1);
+        return;
+    }
+
+    typename BaseField::Element t;
+    norm(t, e1);
+    F.inv(t, t);
+    F.mul(r.a, e1.a, t);
+    F.mul(r.b, e1.b, t);
     F.neg(r.b, r.b);
 }
 
 template <typename BaseField>
-void F2Field<BaseField>::div(Element &r, Element &e1, Element &e2) {
+void F2Field<BaseField>::batchInverse(Element *r, const Element *a, int64_t count, typename BaseField::Element *scratch) {
+    if (!count) return;
+    // Without scratch the norms go to a buffer of each thread that is reused between calls,
+    // so the batch affine additions of G2 do not allocate
+    static thread_local std::vector<typename BaseField::Element> buffer;
+    if (!scratch && (buffer.size() < 2 * (u_int64_t)count)) buffer.resize(2 * count);
+    typename BaseField::Element *norms = scratch ? scratch : buffer.data();
+    typename BaseField::Element *invs = norms + count;
+    bool parallel = count >= F.batchInverseTuning.parallelMin;
+
+    #pragma omp parallel for if(parallel)
+    for (int64_t i=0; i<count; i++) {
+        norm(norms[i], a[i]);
+    }
+
+    F.batchInverse(invs, norms, count, NULL);
+
+    #pragma omp parallel for if(parallel)
+    for (int64_t i=0; i<count; i++) {
+        F.mul2x(r[i].a, a[i].a, invs[i], r[i].b, a[i].b, invs[i]);
+        F.neg(r[i].b, r[i].b);
+    }
+}
+
+template <typename BaseField>
+void F2Field<BaseField>::div(Element &r, const Element &e1, const Element &e2) {
     Element tmp;
     inv(tmp, e2);
     mul(r, e1, tmp);
 }
 
 template <typename BaseField>
-bool F2Field<BaseField>::isZero(Element &a) {
+void F2Field<BaseField>::mulAdd(Element &r, const Element &a, const Element &b, const Element &c) {
+    Element tmp;
+    mul(tmp, a, b);
+    add(r, tmp, c);
+}
+
+template <typename BaseField>
+void F2Field<BaseField>::mulSub(Element &r, const Element &a, const Element &b, const Element &c) {
+    Element tmp;
+    mul(tmp, a, b);
+    sub(r, tmp, c);
+}
+
+template <typename BaseField>
+void F2Field<BaseField>::mulAddMul(Element &r, const Element &a, const Element &b, const Element &c, const Element &d) {
+    Element tmp1, tmp2;
+    mul(tmp1, a, b);
+    mul(tmp2, c, d);
+    add(r, tmp1, tmp2);
+}
+
+template <typename BaseField>
+void F2Field<BaseField>::mulSubMul(Element &r, const Element &a, const Element &b, const Element &c, const Element &d) {
+    Element tmp1, tmp2;
+    mul(tmp1, a, b);
+    mul(tmp2, c, d);
+    sub(r, tmp1, tmp2);
+}
+
+template <typename BaseField>
+bool F2Field<BaseField>::isZero(const Element &a) {
     return F.isZero(a.a) && F.isZero(a.b);
 }
 
 template <typename BaseField>
-bool F2Field<BaseField>::eq(Element &a, Element &b) {
+bool F2Field<BaseField>::eq(const Element &a, const Element &b) {
     return F.eq(a.a, b.a) && F.eq(a.b, b.b);
 }
@@ -1,5 +1,27 @@
 #include <string>
 
+// Fused kernels of the base fields generated with --nr (f2Mul, f2Square and f2Inv). They
+// work on the two coefficients of an element, that are consecutive.
+template <typename BaseField, typename = void>
+struct F2Kernels {
+    static bool match(BaseField &, const typename BaseField::Element &) { return false; }
+    template <typename E> static void mul(BaseField &, E &, const E &, const E &) {}
+    template <typename E> static void square(BaseField &, E &, const E &) {}
+    template <typename E> static void inv(BaseField &, E &, const E &) {}
+};
+
+template <typename BaseField>
+struct F2Kernels<BaseField, decltype(void(&BaseField::f2Mul))> {
+    static bool match(BaseField &F, const typename BaseField::Element &nr) {
+        typename BaseField::Element kernelNr;
+        F.set(kernelNr, BaseField::f2Nr);
+        return F.eq(kernelNr, nr);
+    }
+    template <typename E> static void mul(BaseField &F, E &r, const E &a, const E &b) { F.f2Mul(&r.a, &a.a, &b.a); }
+    template <typename E> static void square(BaseField &F, E &r, const E &a) { F.f2Square(&r.a, &a.a); }
+    template <typename E> static void inv(BaseField &F, E &r, const E &a) { F.f2Inv(&r.a, &a.a); }
+};
+
 template <typename BaseField>
 class F2Field {
 
@@ -13,6 +35,8 @@ public:
 private:
     enum TypeOfNr { nr_is_zero, nr_is_one, nr_is_negone, nr_is_long };
     TypeOfNr typeOfNr;
+    // The base field has kernels for this nr
+    bool hasKernels;
 
     typename BaseField::Element nr;
 
@@ -20,31 +44,52 @@ private:
     Element fZero;
     Element fNegOne;
 
-    void mulByNr(typename BaseField::Element &r, typename BaseField::Element &ab);
+    void mulByNr(typename BaseField::Element &r, const typename BaseField::Element &ab);
+    // r = a0^2 - nr*a1^2, so that a * (a0 - a1*u) = r
+    void norm(typename BaseField::Element &r, const Element &a);
 
-    void initField(typename BaseField::Element &anr);
+    void initField(const typename BaseField::Element &anr);
 public:
 
-    F2Field(typename BaseField::Element &anr);
+    F2Field(const typename BaseField::Element &anr);
     F2Field(std::string nrs);
 
     Element &zero() { return fZero; };
     Element &one() { return fOne; };
     Element &negOne() { return fNegOne; };
 
-    void copy(Element &r, Element &a);
-    void add(Element &r, Element &a, Element &b);
-    void sub(Element &r, Element &a, Element &b);
-    void neg(Element &r, Element &a);
-    void mul(Element &r, Element &a, Element &b);
-    void square(Element &r, Element &a);
-    void inv(Element &r, Element &a);
-    void div(Element &r, Element &a, Element &b);
-    bool isZero(Element &a);
-    bool eq(Element &a, Element &b);
+    void copy(Element &r, const Element &a);
+    void add(Element &r, const Element &a, const Element &b);
+    void sub(Element &r, const Element &a, const Element &b);
+    void neg(Element &r, const Element &a);
+    void mul(Element &r, const Element &a, const Element &b);
+    void square(Element &r, const Element &a);
+    void mulAdd(Element &r, const Element &a, const Element &b, const Element &c);
+    void mulSub(Element &r, const Element &a, const Element &b, const Element &c);
+    void mulAddMul(Element &r, const Element &a, const Element &b, const Element &c, const Element &d);
+    void mulSubMul(Element &r, const Element &a, const Element &b, const Element &c, const Element &d);
+    void inv(Element &r, const Element &a);
+    void div(Element &r, const Element &a, const Element &b);
+    // r[i] = 1/a[i] with a single inversion in the base field: the norms are inverted
+    // together with BaseField::batchInverse and 1/a = (a0 - a1*u)/norm(a). r can be a.
+    // scratch (2*count base field elements) is a reused buffer of the thread when it is NULL.
+    void batchInverse(Element *r, const Element *a, int64_t count, typename BaseField::Element *scratch = NULL);
+
+    Element inline add(const Element &a, const Element &b) { Element r; add(r, a, b); return r; };
+    Element inline sub(const Element &a, const Element &b) { Element r; sub(r, a, b); return r; };
+    Element inline mul(const Element &a, const Element &b) { Element r; mul(r, a, b); return r; };
+    Element inline neg(const Element &a) { Element r; neg(r, a); return r; };
+    Element inline square(const Element &a) { Element r; square(r, a); return r; };
+    // Products by a small integer, coefficient by coefficient
+    Element mul(const Element &a, int b);
+    Element inline mul(int a, const Element &b) { return mul(b, a); };
+    Element set(int value);
+    void set(Element &r, int value) { r = set(value); };
+    bool isZero(const Element &a);
+    bool eq(const Element &a, const Element &b);
 
     void fromString(Element &r, std::string s);
-    std::string toString(Element &a, uint32_t radix = 10);
+    std::string toString(const Element &a, uint32_t radix = 10);
 
 };
 
@@ -1,5 +1,6 @@
 #include <thread>
 #include <vector>
+#include <algorithm>
 #include <omp.h>
 
 using namespace std;
@@ -49,14 +50,12 @@ FFT<Field>::FFT(u_int64_t maxDomainSize, uint32_t _nThreads) {
     mpz_add_ui(m_q, m_aux, 1);
     mpz_fdiv_q_2exp(m_qm1d2, m_aux, 1);
 
-    mpz_set_ui(m_nqr, 2);
-    mpz_powm(m_aux, m_nqr, m_qm1d2, m_q);
-    while (mpz_cmp_ui(m_aux, 1) == 0) {
-        mpz_add_ui(m_nqr, m_nqr, 1);
-        mpz_powm(m_aux, m_nqr, m_qm1d2, m_q);
+    f.fromUI(nqr, 2);
+    while (f.legendre(nqr) == 1) {
+        f.add(nqr, nqr, f.one());
     }
 
-    f.fromMpz(nqr, m_nqr);
+    f.toMpz(m_nqr, nqr);
 
     // std::cout << "nqr: " << f.toString(nqr) << std::endl;
 
@@ -179,17 +178,40 @@ void FFT<Field>::fft(Element *a, u_int64_t n) {
     for (u_int32_t s=1; s<=domainPow; s++) {
         u_int64_t m = 1 << s;
         u_int64_t mdiv2 = m >> 1;
+        if ((n>>1) < 4) {
+            for (u_int64_t i=0; i< (n>>1); i++) {
+                Element t;
+                Element u;
+                u_int64_t k=(i/mdiv2)*m;
+                u_int64_t j=i%mdiv2;
+
+                f.mul(t, root(s, j), a[k+j+mdiv2]);
+                f.copy(u,a[k+j]);
+                f.add(a[k+j], t, u);
+                f.sub(a[k+j+mdiv2], u, t);
+            }
+            continue;
+        }
+        // Four butterflies per step. Their products are independent and are issued together
         #pragma omp parallel for
-        for (u_int64_t i=0; i< (n>>1); i++) {
-            Element t;
+        for (u_int64_t i=0; i< (n>>1); i+=4) {
+            Element t[4];
             Element u;
-            u_int64_t k=(i/mdiv2)*m;
-            u_int64_t j=i%mdiv2;
-
-            f.mul(t, root(s, j), a[k+j+mdiv2]);
-            f.copy(u,a[k+j]);
-            f.add(a[k+j], t, u);
-            f.sub(a[k+j+mdiv2], u, t);
+            u_int64_t x[4], y[4];
+            for (int l=0; l<4; l++) {
+                u_int64_t k=((i+l)/mdiv2)*m;
+                u_int64_t j=(i+l)%mdiv2;
+                x[l] = k+j;
+                y[l] = j;
+            }
+
+            f.mul4x(t[0], root(s, y[0]), a[x[0]+mdiv2], t[1], root(s, y[1]), a[x[1]+mdiv2],
+                    t[2], root(s, y[2]), a[x[2]+mdiv2], t[3], root(s, y[3]), a[x[3]+mdiv2]);
+            for (int l=0; l<4; l++) {
+                f.copy(u,a[x[l]]);
+                f.add(a[x[l]], t[l], u);
+                f.sub(a[x[l]+mdiv2], u, t[l]);
+            }
         }
     }
 }
@@ -201,14 +223,9 @@ void FFT<Field>::ifft(Element *a, u_int64_t n ) {
     u_int64_t nDiv2= n >> 1; 
     #pragma omp parallel for
     for (u_int64_t i=1; i<nDiv2; i++) {
-        Element tmp;
-        u_int64_t r = n-i;
-        f.copy(tmp, a[i]);
-        f.mul(a[i], a[r], powTwoInv[domainPow]);
-        f.mul(a[r], tmp, powTwoInv[domainPow]);
-    } 
-    f.mul(a[0], a[0], powTwoInv[domainPow]);
-    f.mul(a[n >> 1], a[n >> 1], powTwoInv[domainPow]);
+        f.swap(a[i], a[n-i]);
+    }
+    VecOps<Field>().scale(a, a, powTwoInv[domainPow], n);
 }
 
 
@@ -1,6 +1,8 @@
 #ifndef FFT_H
 #define FFT_H
 
+#include "vecops.hpp"
+
 template <typename Field>
 class FFT {
     Field f;
@@ -25,6 +27,7 @@ public:
     void ifft(Element *a, u_int64_t n );
 
     u_int32_t log2(u_int64_t n);
+    inline u_int64_t maxDomainSize() { return (u_int64_t)1 << s; }
     inline Element &root(u_int32_t domainPow, u_int64_t idx) { return roots[ idx << (s-domainPow)]; }
 
     void printVector(Element *a, u_int64_t n );
@@ -0,0 +1,101 @@
+#include <stdexcept>
+
+template <typename Curve>
+FixedBaseTable<Curve>::FixedBaseTable(Curve &_g, const PointAffine &base, uint32_t _scalarSize, uint32_t _windowBits) :
+    g(_g),
+    scalarSize(_scalarSize),
+    windowBits(_windowBits)
+{
+    if ((windowBits < FIXED_BASE_MIN_WINDOW_BITS) || (windowBits > FIXED_BASE_MAX_WINDOW_BITS)) {
+        throw std::invalid_argument("Invalid window size");
+    }
+    // The last window takes the carry of the signed digits
+    nWindows = scalarSize*8/windowBits + 1;
+    pointsPerWindow = 1ULL << (windowBits-1);
+    table = new PointAffine[nWindows*pointsPerWindow];
+
+    // 2^(w*j) * base
+    Point *windowBases = new Point[nWindows];
+    g.copy(windowBases[0], base);
+    for (uint32_t j=1; j<nWindows; j++) {
+        g.copy(windowBases[j], windowBases[j-1]);
+        for (uint32_t k=0; k<windowBits; k++) g.dbl(windowBases[j], windowBases[j]);
+    }
+
+    // Each window is converted to affine with its own batch inversion
+    #pragma omp parallel for
+    for (int64_t j=0; j<(int64_t)nWindows; j++) {
+        Point *points = new Point[pointsPerWindow];
+        g.copy(points[0], windowBases[j]);
+        for (uint64_t d=1; d<pointsPerWindow; d++) {
+            g.add(points[d], points[d-1], windowBases[j]);
+        }
+        g.batchToAffine(table + j*pointsPerWindow, points, pointsPerWindow);
+        delete[] points;
+    }
+
+    delete[] windowBases;
+}
+
+template <typename Curve>
+FixedBaseTable<Curve>::~FixedBaseTable() {
+    delete[] table;
+}
+
+template <typename Curve>
+uint64_t FixedBaseTable<Curve>::tableSize(uint32_t scalarSize, uint32_t windowBits) {
+    return (scalarSize*8/windowBits + 1) * (1ULL << (windowBits-1)) * sizeof(PointAffine);
+}
+
+template <typename Curve>
+uint32_t FixedBaseTable<Curve>::windowBitsForSize(uint32_t scalarSize, uint64_t maxBytes) {
+    uint32_t w = FIXED_BASE_MIN_WINDOW_BITS;
+    while ((w < FIXED_BASE_MAX_WINDOW_BITS) && (tableSize(scalarSize, w+1) <= maxBytes)) w++;
+    return w;
+}
+
+// windowBits bits from bitStart, zero past the end of the scalar
+template <typename Curve>
+uint32_t FixedBaseTable<Curve>::getBits(const uint8_t *scalar, uint32_t bitStart) {
+    uint32_t byteStart = bitStart/8;
+    uint64_t v = 0;
+    for (uint32_t i=0; (i<4) && (byteStart+i<scalarSize); i++) {
+        v |= (uint64_t)scalar[byteStart+i] << (8*i);
+    }
+    v >>= bitStart - byteStart*8;
+    return uint32_t(v & ((1ULL << windowBits) - 1));
+}
+
+template <typename Curve>
+void FixedBaseTable<Curve>::mul(Point &r, const uint8_t *scalar) {
+    g.copy(r, g.zero());
+    uint32_t carry = 0;
+    for (uint32_t j=0; j<nWindows; j++) {
+        int64_t d = getBits(scalar, j*windowBits) + carry;
+        if (d > (int64_t)pointsPerWindow) {
+            d -= 2*pointsPerWindow;
+            carry = 1;
+        } else {
+            carry = 0;
+        }
+        if (d > 0) {
+            g.add(r, r, table[j*pointsPerWindow + d - 1]);
+        } else if (d < 0) {
+            g.sub(r, r, table[j*pointsPerWindow - d - 1]);
+        }
+    }
+}
+
+template <typename Curve>
+void FixedBaseTable<Curve>::mulMany(PointAffine *r, const uint8_t *scalars, uint64_t n) {
+    Point *points = new Point[FIXED_BASE_BLOCK];
+    for (uint64_t i=0; i<n; i+=FIXED_BASE_BLOCK) {
+        uint64_t m = n-i < FIXED_BASE_BLOCK ? n-i : FIXED_BASE_BLOCK;
+        #pragma omp parallel for
+        for (int64_t k=0; k<(int64_t)m; k++) {
+            mul(points[k], scalars + (i+k)*scalarSize);
+        }
+        g.batchToAffine(r + i, points, m);
+    }
+    delete[] points;
+}
@@ -0,0 +1,47 @@
+#ifndef FIXED_BASE_TABLE_H
+#define FIXED_BASE_TABLE_H
+
+#include <stdint.h>
+
+#define FIXED_BASE_MIN_WINDOW_BITS 2
+#define FIXED_BASE_MAX_WINDOW_BITS 20
+// Points of mulMany converted to affine with each batch inversion
+#define FIXED_BASE_BLOCK 4096
+
+// Multiples of a fixed point, precomputed once. The scalar is cut in windows of w bits
+// recoded to signed digits in [-2^(w-1), 2^(w-1)], and the table keeps d * 2^(w*j) * base
+// for d = 1 .. 2^(w-1) in affine form, so a product is one mixed addition per window and
+// no doublings. The table takes (scalarSize*8/w + 1) * 2^(w-1) affine points.
+template <typename Curve>
+class FixedBaseTable {
+    typedef typename Curve::Point Point;
+    typedef typename Curve::PointAffine PointAffine;
+
+    Curve &g;
+    uint32_t scalarSize;
+    uint32_t windowBits;
+    uint32_t nWindows;
+    uint64_t pointsPerWindow;
+    PointAffine *table;
+
+    inline uint32_t getBits(const uint8_t *scalar, uint32_t bitStart);
+
+public:
+
+    FixedBaseTable(Curve &_g, const PointAffine &base, uint32_t _scalarSize = 32, uint32_t _windowBits = 8);
+    ~FixedBaseTable();
+
+    // Bytes of the table for these sizes
+    static uint64_t tableSize(uint32_t scalarSize, uint32_t windowBits);
+    // Largest window whose table fits in maxBytes
+    static uint32_t windowBitsForSize(uint32_t scalarSize, uint64_t maxBytes);
+
+    // Scalars of scalarSize bytes, little endian
+    void mul(Point &r, const uint8_t *scalar);
+    // r[i] = scalars[i] * base in parallel, converted to affine in batches
+    void mulMany(PointAffine *r, const uint8_t *scalars, uint64_t n);
+};
+
+#include "fixed_base_table.cpp"
+
+#endif // FIXED_BASE_TABLE_H
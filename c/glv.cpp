@@ -0,0 +1,256 @@
+#include <gmp.h>
+#include <string.h>
+#include <stdexcept>
+#include <omp.h>
+#include "naf.hpp"
+
+template <typename BaseField>
+Glv<BaseField>::Glv(G &_g, std::string betas, std::string lambdas, std::string orders) : g(_g) {
+    g.F.fromString(beta, betas);
+
+    mpz_t r, lambda, r0, r1, t0, t1, q, tmp, sqrtR;
+    mpz_t a[3], b[3];
+    mpz_inits(r, lambda, r0, r1, t0, t1, q, tmp, sqrtR, NULL);
+    for (int i=0; i<3; i++) mpz_inits(a[i], b[i], NULL);
+    mpz_set_str(r, orders.c_str(), 10);
+    mpz_set_str(lambda, lambdas.c_str(), 10);
+    if (mpz_sizeinbase(r, 2) > GLV_MAX_SCALAR_SIZE*8) {
+        throw std::range_error("GLV order too big");
+    }
+    mpz_add_ui(tmp, lambda, 1);
+    mpz_mul(tmp, tmp, lambda);
+    mpz_add_ui(tmp, tmp, 1);
+    if (!mpz_divisible_p(tmp, r)) {
+        throw std::invalid_argument("lambda is not a cube root of unity");
+    }
+
+    // Extended Euclid on (r, lambda) until the remainder is below sqrt(r). Each step gives
+    // r_i = s_i*r + t_i*lambda, so (r_i, -t_i) is in the lattice (Guide to Elliptic Curve
+    // Cryptography, algorithm 3.74).
+    mpz_sqrt(sqrtR, r);
+    mpz_set(r0, r);
+    mpz_set(r1, lambda);
+    mpz_set_ui(t0, 0);
+    mpz_set_ui(t1, 1);
+    while (mpz_cmp(r1, sqrtR) >= 0) {
+        mpz_fdiv_q(q, r0, r1);
+        mpz_submul(r0, q, r1);
+        mpz_swap(r0, r1);
+        mpz_submul(t0, q, t1);
+        mpz_swap(t0, t1);
+    }
+    // v1 = (r_l+1, -t_l+1) and v2 the shortest of (r_l, -t_l) and (r_l+2, -t_l+2)
+    mpz_set(a[0], r1);
+    mpz_neg(b[0], t1);
+    mpz_set(a[1], r0);
+    mpz_neg(b[1], t0);
+    mpz_fdiv_q(q, r0, r1);
+    mpz_submul(r0, q, r1);
+    mpz_submul(t0, q, t1);
+    mpz_set(a[2], r0);
+    mpz_neg(b[2], t0);
+    mpz_mul(tmp, a[1], a[1]);
+    mpz_addmul(tmp, b[1], b[1]);
+    mpz_mul(q, a[2], a[2]);
+    mpz_addmul(q, b[2], b[2]);
+    if (mpz_cmp(q, tmp) < 0) {
+        mpz_swap(a[1], a[2]);
+        mpz_swap(b[1], b[2]);
+    }
+
+    // The halves are about (|a1| + |a2|)/2 and (|b1| + |b2|)/2 at most and must fit in signed 128 bits
+    mpz_t *ab[2] = { a, b };
+    for (int i=0; i<2; i++) {
+        mpz_abs(tmp, ab[i][0]);
+        mpz_abs(q, ab[i][1]);
+        mpz_add(tmp, tmp, q);
+        if (mpz_sizeinbase(tmp, 2) > 127) {
+            throw std::range_error("GLV basis too big");
+        }
+    }
+
+    uint128 *basis[4] = { &a1, &b1, &a2, &b2 };
+    mpz_t *basisMpz[4] = { &a[0], &b[0], &a[1], &b[1] };
+    for (int i=0; i<4; i++) {
+        uint64_t limbs[2] = {0, 0};
+        mpz_abs(tmp, *basisMpz[i]);
+        mpz_export(limbs, NULL, -1, 8, 0, 0, tmp);
+        *basis[i] = ((uint128)limbs[1] << 64) | limbs[0];
+        if (mpz_sgn(*basisMpz[i]) < 0) *basis[i] = -*basis[i];
+    }
+
+    // det = a1*b2 - a2*b1 = +-r. g = round(2^384 * num / det), as floor((2*num + det) / (2*det)) with det > 0
+    mpz_t det;
+    mpz_init(det);
+    mpz_mul(det, a[0], b[1]);
+    mpz_submul(det, a[1], b[0]);
+    uint64_t *gs[2] = { g1, g2 };
+    bool *gNeg[2] = { &g1Neg, &g2Neg };
+    for (int i=0; i<2; i++) {
+        if (i==0) mpz_set(tmp, b[1]); else mpz_neg(tmp, b[0]);
+        if (mpz_sgn(det) < 0) mpz_neg(tmp, tmp);
+        mpz_abs(q, det);
+        mpz_mul_2exp(tmp, tmp, 385);
+        mpz_add(tmp, tmp, q);
+        mpz_mul_2exp(q, q, 1);
+        mpz_fdiv_q(tmp, tmp, q);
+        *gNeg[i] = mpz_sgn(tmp) < 0;
+        mpz_abs(tmp, tmp);
+        if (mpz_sizeinbase(tmp, 2) > GLV_G_LIMBS*64) {
+            throw std::range_error("GLV basis too big");
+        }
+        memset(gs[i], 0, GLV_G_LIMBS*8);
+        mpz_export(gs[i], NULL, -1, 8, 0, 0, tmp);
+    }
+
+    mpz_clears(r, lambda, r0, r1, t0, t1, q, tmp, sqrtR, det, NULL);
+    for (int i=0; i<3; i++) mpz_clears(a[i], b[i], NULL);
+}
+
+// round(k * gb / 2^384), negated if neg, modulo 2^128
+template <typename BaseField>
+typename Glv<BaseField>::uint128 Glv<BaseField>::roundedQuotient(const uint64_t *k, const uint64_t *gb, bool neg) {
+    const int kLimbs = GLV_MAX_SCALAR_SIZE/8;
+    uint64_t p[kLimbs + GLV_G_LIMBS];
+    memset(p, 0, sizeof(p));
+    for (int i=0; i<kLimbs; i++) {
+        uint64_t carry = 0;
+        for (int j=0; j<GLV_G_LIMBS; j++) {
+            uint128 t = (uint128)k[i]*gb[j] + p[i+j] + carry;
+            p[i+j] = (uint64_t)t;
+            carry = (uint64_t)(t >> 64);
+        }
+        p[i+GLV_G_LIMBS] = carry;
+    }
+    // + 2^383 and the bits 384..511
+    uint128 t = (uint128)p[5] + (1ULL << 63);
+    t = (t >> 64) + p[6];
+    uint128 c = (uint64_t)t;
+    t = (t >> 64) + p[7];
+    c |= t << 64;
+    return neg ? -c : c;
+}
+
+template <typename BaseField>
+void Glv<BaseField>::setHalf(uint8_t *half, bool &neg, uint128 v) {
+    neg = (v >> 127) != 0;
+    if (neg) v = -v;
+    memcpy(half, &v, GLV_HALF_SIZE);
+}
+
+template <typename BaseField>
+void Glv<BaseField>::decompose(uint8_t *k1, bool &neg1, uint8_t *k2, bool &neg2, const uint8_t *scalar, unsigned int scalarSize) {
+    uint64_t k[GLV_MAX_SCALAR_SIZE/8];
+    memset(k, 0, sizeof(k));
+    memcpy(k, scalar, scalarSize);
+
+    // c1 = round(k*b2/det), c2 = round(-k*b1/det). (k1, k2) = (k, 0) - c1*(a1, b1) - c2*(a2, b2)
+    // is short, so it is computed modulo 2^128.
+    uint128 c1 = roundedQuotient(k, g1, g1Neg);
+    uint128 c2 = roundedQuotient(k, g2, g2Neg);
+    uint128 kl = ((uint128)k[1] << 64) | k[0];
+
+    setHalf(k1, neg1, kl - c1*a1 - c2*a2);
+    setHalf(k2, neg2, - c1*b1 - c2*b2);
+}
+
+template <typename BaseField>
+void Glv<BaseField>::endomorphism(Point &r, const Point &a) {
+    g.F.mul(r.x, beta, a.x);
+    g.F.copy(r.y, a.y);
+    g.F.copy(r.zz, a.zz);
+    g.F.copy(r.zzz, a.zzz);
+}
+
+template <typename BaseField>
+void Glv<BaseField>::endomorphism(PointAffine &r, const PointAffine &a) {
+    g.F.mul(r.x, beta, a.x);
+    g.F.copy(r.y, a.y);
+}
+
+// Both NAFs are walked together: one doubling per bit of the halves
+template <typename BaseField>
+template <typename PointIn>
+void Glv<BaseField>::glvMulByScalar(Point &r, const PointIn &base, const uint8_t *scalar, unsigned int scalarSize) {
+    if (scalarSize > GLV_MAX_SCALAR_SIZE) {
+        g.mulByScalar(r, base, scalar, scalarSize);
+        return;
+    }
+
+    uint8_t k[2][GLV_HALF_SIZE];
+    bool neg[2];
+    decompose(k[0], neg[0], k[1], neg[1], scalar, scalarSize);
+
+    PointIn p[2];
+    g.copy(p[0], base); // base and result can be the same
+    endomorphism(p[1], p[0]);
+    for (int j=0; j<2; j++) {
+        if (neg[j]) g.neg(p[j], p[j]);
+    }
+
+    const int nBits = (GLV_HALF_SIZE+2)*8;
+    uint8_t naf[2][nBits];
+    buildNaf(naf[0], k[0], GLV_HALF_SIZE);
+    buildNaf(naf[1], k[1], GLV_HALF_SIZE);
+
+    g.copy(r, g.zero());
+    int i = nBits-1;
+    while ((i>=0)&&(naf[0][i] == 0)&&(naf[1][i] == 0)) i--;
+    while (i>=0) {
+        g.dbl(r, r);
+        for (int j=0; j<2; j++) {
+            if (naf[j][i] == 1) {
+                g.add(r, r, p[j]);
+            } else if (naf[j][i] == 2) {
+                g.sub(r, r, p[j]);
+            }
+        }
+        i--;
+    }
+}
+
+template <typename BaseField>
+void Glv<BaseField>::split(PointAffine *splitBases, uint8_t *splitScalars, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, unsigned int n) {
+    #pragma omp parallel for
+    for (int64_t i=0; i<(int64_t)n; i++) {
+        bool neg1, neg2;
+        decompose(splitScalars + 2*i*GLV_HALF_SIZE, neg1, splitScalars + (2*i+1)*GLV_HALF_SIZE, neg2, scalars + i*scalarSize, scalarSize);
+        if (neg1) g.neg(splitBases[2*i], bases[i]); else g.copy(splitBases[2*i], bases[i]);
+        endomorphism(splitBases[2*i+1], bases[i]);
+        if (neg2) g.neg(splitBases[2*i+1], splitBases[2*i+1]);
+    }
+}
+
+template <typename BaseField>
+void Glv<BaseField>::multiMulByScalar(Point &r, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, unsigned int n, unsigned int nThreads) {
+    if (scalarSize > GLV_MAX_SCALAR_SIZE) {
+        g.multiMulByScalar(r, (PointAffine *)bases, (uint8_t *)scalars, scalarSize, n, nThreads);
+        return;
+    }
+    PointAffine *splitBases = new PointAffine[2*(uint64_t)n];
+    uint8_t *splitScalars = new uint8_t[2*(uint64_t)n*GLV_HALF_SIZE];
+    split(splitBases, splitScalars, bases, scalars, scalarSize, n);
+
+    ParallelMultiexp<G> pm(g);
+    pm.multiexp(r, splitBases, splitScalars, GLV_HALF_SIZE, 2*n, nThreads);
+
+    delete[] splitBases;
+    delete[] splitScalars;
+}
+
+template <typename BaseField>
+void Glv<BaseField>::multiMulByScalarBa(Point &r, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, unsigned int n, unsigned int nThreads) {
+    if (scalarSize > GLV_MAX_SCALAR_SIZE) {
+        g.multiMulByScalarBa(r, bases, scalars, scalarSize, n, nThreads);
+        return;
+    }
+    PointAffine *splitBases = new PointAffine[2*(uint64_t)n];
+    uint8_t *splitScalars = new uint8_t[2*(uint64_t)n*GLV_HALF_SIZE];
+    split(splitBases, splitScalars, bases, scalars, scalarSize, n);
+
+    ParallelMultiexpBa<G> pm(g);
+    pm.multiexp(r, splitBases, splitScalars, GLV_HALF_SIZE, 2*n, nThreads);
+
+    delete[] splitBases;
+    delete[] splitScalars;
+}
@@ -0,0 +1,72 @@
+#ifndef GLV_H
+#define GLV_H
+
+#include <stdint.h>
+#include <string>
+
+// Bytes of each half of a decomposed scalar
+#define GLV_HALF_SIZE 16
+// Scalars up to this size are decomposed. Longer ones take the methods of the curve.
+#define GLV_MAX_SCALAR_SIZE 32
+// Limbs of the precomputed 2^384 * b / r
+#define GLV_G_LIMBS 6
+
+// Scalar multiplication with the endomorphism (x, y) -> (beta*x, y) of the curves with
+// a = 0, which multiplies the points of the group by lambda. A scalar k is split in
+// k1 + k2*lambda with k1 and k2 of about half the bits of the order (Gallant, Lambert,
+// Vanstone), so k*P = k1*P + k2*phi(P): the single point multiplication doubles half the
+// times and the multiexps take 2n points with half the windows.
+// The curve must be included before.
+template <typename BaseField>
+class Glv {
+    typedef Curve<BaseField> G;
+    typedef typename G::Point Point;
+    typedef typename G::PointAffine PointAffine;
+    typedef unsigned __int128 uint128;
+
+    G &g;
+    typename BaseField::Element beta;
+
+    // Short basis (a1, b1), (a2, b2) of the lattice of a + b*lambda = 0 (mod r), modulo 2^128
+    uint128 a1, b1, a2, b2;
+    // |round(2^384 * b2 / det)| and |round(-2^384 * b1 / det)| and their signs
+    uint64_t g1[GLV_G_LIMBS];
+    uint64_t g2[GLV_G_LIMBS];
+    bool g1Neg, g2Neg;
+
+    static uint128 roundedQuotient(const uint64_t *k, const uint64_t *gb, bool neg);
+    static void setHalf(uint8_t *half, bool &neg, uint128 v);
+
+    template <typename PointIn>
+    void glvMulByScalar(Point &r, const PointIn &base, const uint8_t *scalar, unsigned int scalarSize);
+    // Expands to 2n bases and scalars of GLV_HALF_SIZE bytes. The signs go in the bases.
+    void split(PointAffine *splitBases, uint8_t *splitScalars, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, unsigned int n);
+
+public:
+
+    // beta is a cube root of unity of the base field and lambda the one of the scalar
+    // field of order r with lambda*P = (beta*x, y)
+    Glv(G &_g, std::string betas, std::string lambdas, std::string orders);
+
+    // scalar = k1 + k2*lambda (mod r). k1 and k2 take GLV_HALF_SIZE bytes, little endian.
+    void decompose(uint8_t *k1, bool &neg1, uint8_t *k2, bool &neg2, const uint8_t *scalar, unsigned int scalarSize);
+
+    void endomorphism(Point &r, const Point &a);
+    void endomorphism(PointAffine &r, const PointAffine &a);
+
+    void mulByScalar(Point &r, const Point &base, const uint8_t *scalar, unsigned int scalarSize) {
+        glvMulByScalar<Point>(r, base, scalar, scalarSize);
+    }
+
+    void mulByScalar(Point &r, const PointAffine &base, const uint8_t *scalar, unsigned int scalarSize) {
+        glvMulByScalar<PointAffine>(r, base, scalar, scalarSize);
+    }
+
+    // They allocate the 2n split bases and scalars
+    void multiMulByScalar(Point &r, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, unsigned int n, unsigned int nThreads=0);
+    void multiMulByScalarBa(Point &r, const PointAffine *bases, const uint8_t *scalars, unsigned int scalarSize, unsigned int n, unsigned int nThreads=0);
+};
+
+#include "glv.cpp"
+
+#endif // GLV_H
@@ -1,3 +1,5 @@
+#include <string.h>
+#include <stdexcept>
 #include "naf.hpp"
 
 static uint64_t NAFTable[1024];
@@ -74,3 +76,41 @@ void buildNaf(uint8_t *r, const uint8_t* scalar, unsigned int scalarSize) {
 }
 
 static bool tableBulded = buildNafTable();
+
+// w bits from bit, zero past the end of the scalar
+static inline unsigned int getBits(const uint8_t* scalar, unsigned int scalarSize, unsigned int bit, unsigned int w) {
+    unsigned int byte = bit/8;
+    unsigned int v = scalar[byte];
+    if (byte+1 < scalarSize) v |= scalar[byte+1] << 8;
+    return (v >> (bit%8)) & ((1 << w) - 1);
+}
+
+int buildWNaf(int8_t *r, const uint8_t* scalar, unsigned int scalarSize, unsigned int w) {
+    if ((w < 2) || (w > WNAF_MAX_WIDTH)) {
+        throw std::invalid_argument("Invalid wNAF width");
+    }
+    int nBits = scalarSize*8;
+    int last = -1;
+    int carry = 0;
+    int bit = 0;
+
+    memset(r, 0, nBits+1);
+    while (bit < nBits) {
+        if ((int)getBits(scalar, scalarSize, bit, 1) == carry) {
+            bit++;
+            continue;
+        }
+        int now = (int)w < nBits - bit ? w : nBits - bit;
+        int word = getBits(scalar, scalarSize, bit, now) + carry;
+        carry = (word >> (w-1)) & 1;
+        word -= carry << w;
+        r[bit] = word;
+        last = bit;
+        bit += now;
+    }
+    if (carry) {
+        r[nBits] = 1;
+        last = nBits;
+    }
+    return last+1;
+}
@@ -1,3 +1,11 @@
 #include <stdint.h>
 
 void buildNaf(uint8_t *r, const uint8_t* scalar, unsigned int scalarSize);
+
+#define WNAF_MAX_WIDTH 8
+
+// Width w NAF, least significant digit first: each digit is zero or odd with
+// |d| < 2^(w-1), and of any w consecutive digits at most one is not zero.
+// r takes scalarSize*8+1 digits. Returns the number of digits up to the last non zero one.
+// Throws std::invalid_argument if w is not in [2, WNAF_MAX_WIDTH].
+int buildWNaf(int8_t *r, const uint8_t* scalar, unsigned int scalarSize, unsigned int w);
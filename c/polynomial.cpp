@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <omp.h>
+
+template <typename Field>
+PolynomialArena<Field>::PolynomialArena(u_int64_t initialSize) {
+    blocks.push_back({ initialSize ? new Element[initialSize] : NULL, initialSize });
+    used = 0;
+    live = 0;
+    peak = 0;
+}
+
+template <typename Field>
+PolynomialArena<Field>::~PolynomialArena() {
+    for (auto &b : blocks) delete[] b.buff;
+}
+
+template <typename Field>
+typename Field::Element *PolynomialArena<Field>::alloc(u_int64_t n) {
+    if (used + n > blocks.back().size) {
+        u_int64_t size = std::max(n, 2*blocks.back().size);
+        blocks.push_back({ new Element[size], size });
+        used = 0;
+    }
+    Element *r = blocks.back().buff + used;
+    used += n;
+    live += n;
+    peak = std::max(peak, live);
+    return r;
+}
+
+template <typename Field>
+void PolynomialArena<Field>::release(const Mark &m) {
+    while (blocks.size() > m.block + 1) {
+        delete[] blocks.back().buff;
+        blocks.pop_back();
+    }
+    used = m.used;
+    live = m.live;
+    if ((m.block == 0) && (m.used == 0)) {
+        if (peak > blocks[0].size) {
+            delete[] blocks[0].buff;
+            blocks[0].buff = new Element[peak];
+            blocks[0].size = peak;
+        }
+        peak = 0;
+    }
+}
+
+template <typename Field>
+Polynomial<Field>::Polynomial(FFT<Field> &_fft, PolynomialArena<Field> &_arena) :
+    f(Field::field),
+    fft(_fft),
+    arena(_arena)
+{
+}
+
+template <typename Field>
+void Polynomial<Field>::mul(Element *r, const Element *a, u_int64_t na, const Element *b, u_int64_t nb) {
+    if ((na == 0) || (nb == 0)) return;
+    u_int64_t nr = na + nb - 1;
+    auto m = arena.mark();
+    const u_int64_t blockSize = 1024;
+
+    if (std::min(na, nb) <= POLYNOMIAL_SCHOOLBOOK) {
+        Element *t = arena.alloc(nr);
+        #pragma omp parallel for if(nr > blockSize)
+        for (u_int64_t i=0; i<nr; i++) {
+            u_int64_t from = i >= nb ? i - nb + 1 : 0;
+            u_int64_t to = std::min(i, na - 1);
+            f.mul(t[i], a[from], b[i - from]);
+            for (u_int64_t j=from+1; j<=to; j++) f.mulAdd(t[i], a[j], b[i - j], t[i]);
+        }
+        f.copyN(r, t, nr);
+        arena.release(m);
+        return;
+    }
+
+    u_int64_t n = 1;
+    while (n < nr) n <<= 1;
+    if (n > fft.maxDomainSize()) {
+        arena.release(m);
+        throw std::range_error("Polynomial product too big for the FFT domain");
+    }
+
+    // A square needs a single transform
+    bool square = (a == b) && (na == nb);
+    Element *ta = arena.alloc(n);
+    Element *tb = square ? ta : arena.alloc(n);
+    #pragma omp parallel for
+    for (u_int64_t i=0; i<n; i += blockSize) {
+        for (u_int64_t j=i; j<std::min(i + blockSize, n); j++) {
+            f.copy(ta[j], j < na ? a[j] : f.zero());
+            if (!square) f.copy(tb[j], j < nb ? b[j] : f.zero());
+        }
+    }
+    fft.fft(ta, n);
+    if (!square) fft.fft(tb, n);
+    if (square) {
+        VecOps<Field>().square(ta, ta, n);
+    } else {
+        VecOps<Field>().mul(ta, ta, tb, n);
+    }
+    fft.ifft(ta, n);
+    #pragma omp parallel for
+    for (u_int64_t i=0; i<nr; i += blockSize) {
+        f.copyN(r + i, ta + i, std::min(blockSize, nr - i));
+    }
+    arena.release(m);
+}
+
+template <typename Field>
+bool Polynomial<Field>::divByXnMinus1(Element *q, const Element *a, u_int64_t na, u_int64_t n, Element *rem) {
+    assert(n > 0);
+    bool exact = true;
+
+    // q[i] = a[i+n] + q[i+n], so each residue modulo n is an independent chain that is
+    // walked from the top. a[k] is read before q[k] is written, so q can be a.
+    #pragma omp parallel for reduction(&&:exact) if(na > 1024)
+    for (u_int64_t j=0; j<n; j++) {
+        Element c;
+        Element prev;
+        f.copy(c, f.zero());
+        f.copy(prev, j < na ? a[j] : f.zero());
+        if (j + n < na) {
+            u_int64_t k = j + ((na - 1 - j) / n) * n;
+            f.copy(prev, a[k]);
+            for (; k >= j + n; k -= n) {
+                f.add(c, c, prev);
+                f.copy(prev, a[k - n]);
+                f.copy(q[k - n], c);
+            }
+        }
+        // rem[j] = a[j] + q[j]
+        f.add(c, c, prev);
+        if (rem) f.copy(rem[j], c);
+        if (!f.isZero(c)) exact = false;
+    }
+    return exact;
+}
+
+template <typename Field>
+typename Field::Element Polynomial<Field>::divByXMinusZ(Element *q, const Element *a, u_int64_t na, const Element &z) {
+    Element res;
+    if (na == 0) {
+        f.copy(res, f.zero());
+        return res;
+    }
+    if (na == 1) {
+        f.copy(res, a[0]);
+        return res;
+    }
+
+    // q[i] = z * q[i+1] + a[i+1] with q[na-1] = 0. The quotient is cut in one block per
+    // thread: the first pass finds what each block passes down if it received zero, the
+    // carries are chained from the top and the second pass writes the blocks.
+    u_int64_t nq = na - 1;
+    int nBlocks = omp_get_max_threads();
+    u_int64_t blockSize = std::max((nq + nBlocks - 1) / nBlocks, (u_int64_t)POLYNOMIAL_MIN_BLOCK);
+    nBlocks = (nq + blockSize - 1) / blockSize;
+
+    auto m = arena.mark();
+    Element *carry = arena.alloc(nBlocks);
+    Element *top = arena.alloc(nBlocks);
+    Element a0;
+    f.copy(a0, a[0]);
+
+    #pragma omp parallel for if(nBlocks > 1)
+    for (int b=0; b<nBlocks; b++) {
+        u_int64_t from = b * blockSize;
+        u_int64_t to = std::min(from + blockSize, nq);
+        Element c;
+        Element prev;
+        f.copy(c, f.zero());
+        f.copy(top[b], a[to]);
+        f.copy(prev, a[to]);
+        for (u_int64_t i=to; i-- > from;) {
+            f.mulAdd(c, c, z, prev);
+            f.copy(prev, a[i]);
+        }
+        f.copy(carry[b], c);
+    }
+
+    if (nBlocks > 1) {
+        // carry[b] becomes q[b * blockSize]. All the blocks but the last have blockSize.
+        Element zb;
+        f.exp(zb, z, (uint8_t *)(&blockSize), sizeof(blockSize));
+        for (int b=nBlocks-2; b>=0; b--) f.mulAdd(carry[b], carry[b + 1], zb, carry[b]);
+
+        #pragma omp parallel for
+        for (int b=0; b<nBlocks; b++) {
+            u_int64_t from = b * blockSize;
+            u_int64_t to = std::min(from + blockSize, nq);
+            Element c;
+            Element prev;
+            f.copy(c, b == nBlocks - 1 ? f.zero() : carry[b + 1]);
+            f.copy(prev, top[b]);
+            for (u_int64_t i=to; i-- > from;) {
+                f.mulAdd(c, c, z, prev);
+                f.copy(prev, a[i]);
+                f.copy(q[i], c);
+            }
+        }
+    } else {
+        Element c;
+        Element prev;
+        f.copy(c, f.zero());
+        f.copy(prev, a[nq]);
+        for (u_int64_t i=nq; i-- > 0;) {
+            f.mulAdd(c, c, z, prev);
+            f.copy(prev, a[i]);
+            f.copy(q[i], c);
+        }
+        f.copy(carry[0], c);
+    }
+
+    f.mulAdd(res, carry[0], z, a0);
+    arena.release(m);
+    return res;
+}
+
+template <typename Field>
+void Polynomial<Field>::evaluate(Element &r, const Element *a, u_int64_t na, const Element &z) {
+    if (na == 0) {
+        f.copy(r, f.zero());
+        return;
+    }
+    int nBlocks = omp_get_max_threads();
+    u_int64_t blockSize = std::max((na + nBlocks - 1) / nBlocks, (u_int64_t)POLYNOMIAL_MIN_BLOCK);
+    nBlocks = (na + blockSize - 1) / blockSize;
+
+    // a(z) = sum(v[b] * z^(b * blockSize)), with v[b] the Horner value of the block
+    auto m = arena.mark();
+    Element *v = arena.alloc(nBlocks);
+    #pragma omp parallel for if(nBlocks > 1)
+    for (int b=0; b<nBlocks; b++) {
+        u_int64_t from = b * blockSize;
+        u_int64_t to = std::min(from + blockSize, na);
+        Element c;
+        f.copy(c, a[to - 1]);
+        for (u_int64_t i=to-1; i-- > from;) f.mulAdd(c, c, z, a[i]);
+        f.copy(v[b], c);
+    }
+
+    Element zb;
+    f.copy(r, v[nBlocks - 1]);
+    if (nBlocks > 1) f.exp(zb, z, (uint8_t *)(&blockSize), sizeof(blockSize));
+    for (int b=nBlocks-2; b>=0; b--) f.mulAdd(r, r, zb, v[b]);
+    arena.release(m);
+}
+
+template <typename Field>
+void Polynomial<Field>::linearCombination(Element *r, const Element *coefs, const Element * const *polys, const u_int64_t *sizes, u_int64_t count) {
+    u_int64_t nr = 0;
+    for (u_int64_t k=0; k<count; k++) nr = std::max(nr, sizes[k]);
+
+    // Each coefficient is accumulated apart, so r can be one of the polynomials
+    #pragma omp parallel for if(nr > 1024)
+    for (u_int64_t i=0; i<nr; i++) {
+        Element acc;
+        f.copy(acc, f.zero());
+        for (u_int64_t k=0; k<count; k++) {
+            if (i < sizes[k]) f.mulAdd(acc, coefs[k], polys[k][i], acc);
+        }
+        f.copy(r[i], acc);
+    }
+}
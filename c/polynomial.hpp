@@ -0,0 +1,82 @@
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <vector>
+#include "fft.hpp"
+
+// Below this number of coefficients in the shortest factor mul uses the schoolbook product
+#define POLYNOMIAL_SCHOOLBOOK 32
+// Minimum number of coefficients per thread in evaluate and divByXMinusZ
+#define POLYNOMIAL_MIN_BLOCK 4096
+
+// Bump allocator of field elements for the temporary buffers of the polynomial operations.
+// When a request does not fit a new block is added, and when everything is released the
+// blocks are merged in one with the most elements that were live at once, so after the first
+// round nothing is allocated.
+template <typename Field>
+class PolynomialArena {
+    typedef typename Field::Element Element;
+
+    struct Block {
+        Element *buff;
+        u_int64_t size;
+    };
+    std::vector<Block> blocks;
+    u_int64_t used;
+    // Elements handed out and not released, and their largest value since the last full release
+    u_int64_t live;
+    u_int64_t peak;
+
+public:
+
+    struct Mark {
+        u_int64_t block;
+        u_int64_t used;
+        u_int64_t live;
+    };
+
+    PolynomialArena(u_int64_t initialSize = 0);
+    ~PolynomialArena();
+
+    // The buffers are valid until the arena is released to a mark taken before them
+    Element *alloc(u_int64_t n);
+    Mark mark() { return { blocks.size() - 1, used, live }; }
+    void release(const Mark &m);
+    u_int64_t capacity() { return blocks[0].size; }
+};
+
+// Polynomials as arrays of coefficients, lowest degree first. The results can be the
+// inputs, the temporary buffers come from the arena and the loops use the OpenMP threads.
+template <typename Field>
+class Polynomial {
+    typedef typename Field::Element Element;
+
+    Field &f;
+    FFT<Field> &fft;
+    PolynomialArena<Field> &arena;
+
+public:
+
+    Polynomial(FFT<Field> &_fft, PolynomialArena<Field> &_arena);
+
+    // r = a * b, with na + nb - 1 coefficients
+    void mul(Element *r, const Element *a, u_int64_t na, const Element *b, u_int64_t nb);
+
+    // a = q * (X^n - 1) + rem. q has na - n coefficients and rem (if not NULL) n. Returns
+    // whether the remainder is zero, i.e. whether the vanishing polynomial of the domain
+    // of size n divides a.
+    bool divByXnMinus1(Element *q, const Element *a, u_int64_t na, u_int64_t n, Element *rem = NULL);
+
+    // a = q * (X - z) + a(z). q has na - 1 coefficients. Returns a(z).
+    Element divByXMinusZ(Element *q, const Element *a, u_int64_t na, const Element &z);
+
+    // r = a(z), with Horner in one block per thread
+    void evaluate(Element &r, const Element *a, u_int64_t na, const Element &z);
+
+    // r = sum(coefs[k] * polys[k]), polys[k] has sizes[k] coefficients and r the largest
+    void linearCombination(Element *r, const Element *coefs, const Element * const *polys, const u_int64_t *sizes, u_int64_t count);
+};
+
+#include "polynomial.cpp"
+
+#endif // POLYNOMIAL_H
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <omp.h>
+
+template <typename Field>
+VecOps<Field>::VecOps() :
+    f(Field::field)
+{
+}
+
+template <typename Field>
+template <typename Op>
+void VecOps<Field>::forBlocks(u_int64_t n, Op op) {
+    #pragma omp parallel for if(n > VECOPS_BLOCK)
+    for (u_int64_t i=0; i<n; i += VECOPS_BLOCK) {
+        op(i, std::min(i + VECOPS_BLOCK, n));
+    }
+}
+
+template <typename Field>
+void VecOps<Field>::mul(Element *r, const Element *a, const Element *b, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        f.mulN(r + from, a + from, b + from, to - from);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::square(Element *r, const Element *a, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        f.squareN(r + from, a + from, to - from);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::mulAdd(Element *r, const Element *a, const Element *b, const Element *c, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        Element t[VECOPS_BLOCK];
+        f.mulN(t, a + from, b + from, to - from);
+        f.addN(r + from, t, c + from, to - from);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::mulSub(Element *r, const Element *a, const Element *b, const Element *c, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        Element t[VECOPS_BLOCK];
+        f.mulN(t, a + from, b + from, to - from);
+        f.subN(r + from, t, c + from, to - from);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::mulSubScale(Element *r, const Element *a, const Element *b, const Element *c, const Element &k, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        Element t[VECOPS_BLOCK];
+        f.mulN(t, a + from, b + from, to - from);
+        f.subN(r + from, t, c + from, to - from);
+        f.mulN(r + from, r + from, k, to - from);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::axpy(Element *y, const Element &k, const Element *x, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        Element t[VECOPS_BLOCK];
+        f.mulN(t, x + from, k, to - from);
+        f.addN(y + from, y + from, t, to - from);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::axpby(Element *r, const Element &ka, const Element *a, const Element &kb, const Element *b, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        for (u_int64_t i=from; i<to; i++) f.mulAddMul(r[i], ka, a[i], kb, b[i]);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::scale(Element *r, const Element *a, const Element &k, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        f.mulN(r + from, a + from, k, to - from);
+    });
+}
+
+template <typename Field>
+void VecOps<Field>::scalePowers(Element *r, const Element *a, const Element &k, const Element &g, u_int64_t n) {
+    forBlocks(n, [&](u_int64_t from, u_int64_t to) {
+        // k * g^from, then one more g per element
+        Element p;
+        f.exp(p, g, (uint8_t *)(&from), sizeof(from));
+        f.mul(p, p, k);
+        for (u_int64_t i=from; i<to; i++) {
+            f.mul2x(r[i], a[i], p, p, p, g);
+        }
+    });
+}
@@ -0,0 +1,47 @@
+#ifndef VECOPS_H
+#define VECOPS_H
+
+// Elements per block. Each thread takes whole blocks and runs the operations of the
+// expression one after the other in the block, while it is in the L1 cache, so the arrays
+// are read and written once from memory.
+#define VECOPS_BLOCK 256
+
+// Element-wise operations over arrays of field elements. Each expression is computed in a
+// single pass over the arrays with the fused field operations, and the blocks are spread
+// among the OpenMP threads. The result can be any of the inputs.
+template <typename Field>
+class VecOps {
+    typedef typename Field::Element Element;
+
+    Field &f;
+
+    template <typename Op>
+    void forBlocks(u_int64_t n, Op op);
+
+public:
+
+    VecOps();
+
+    // r = a * b
+    void mul(Element *r, const Element *a, const Element *b, u_int64_t n);
+    // r = a * a
+    void square(Element *r, const Element *a, u_int64_t n);
+    // r = a * b + c
+    void mulAdd(Element *r, const Element *a, const Element *b, const Element *c, u_int64_t n);
+    // r = a * b - c
+    void mulSub(Element *r, const Element *a, const Element *b, const Element *c, u_int64_t n);
+    // r = (a * b - c) * k, the quotient by the vanishing polynomial in a coset
+    void mulSubScale(Element *r, const Element *a, const Element *b, const Element *c, const Element &k, u_int64_t n);
+    // y = y + k * x
+    void axpy(Element *y, const Element &k, const Element *x, u_int64_t n);
+    // r = ka * a + kb * b
+    void axpby(Element *r, const Element &ka, const Element *a, const Element &kb, const Element *b, u_int64_t n);
+    // r = k * a
+    void scale(Element *r, const Element *a, const Element &k, u_int64_t n);
+    // r[i] = k * g^i * a[i], the shift of the coefficients to a coset
+    void scalePowers(Element *r, const Element *a, const Element &k, const Element &g, u_int64_t n);
+};
+
+#include "vecops.cpp"
+
+#endif // VECOPS_H
@@ -2,7 +2,7 @@
 const assert = require("assert");
 
 module.exports = class RegManager {
-    constructor(name, neededReges) {
+    constructor(name, neededReges, nLocals) {
 
         this.availableRegs = ["rax", "r8", "r9", "r10", "r11"];
         this.pushableRegs = ["r12", "r13", "r14", "r15", "rbp", "rbx"];
@@ -13,11 +13,17 @@ module.exports = class RegManager {
             "adox": ["IOR", "I"],
             "shl": ["IOR", "I"],
             "shr": ["IOR", "I"],
+            "add": ["IO", "I"],
+            "adc": ["IO", "I"],
             "sub": ["IO", "I"],
             "sbb": ["IO", "I"],
+            "and": ["IO", "I"],
+            "neg": ["IO"],
             "cmp": ["I", "I"],
             "test": ["I", "I"],
             "mov": ["O", "I"],
+            "cmovc": ["IO", "I"],
+            "cmovz": ["IO", "I"],
             "mulx": ["OR","OR", "I"],
             "xor": ["IO", "O"],
         };
@@ -26,6 +32,7 @@ module.exports = class RegManager {
 
         this.name = name;
         this.neededRegs = neededReges;
+        this.nLocals = nLocals || 0;
         this.regRefs = [];
 
         this.wrAvailable;
@@ -39,7 +46,7 @@ module.exports = class RegManager {
         } else {
             this.nUsedRegs = this.neededRegs;
             this.wrAvailable = null;
-            this.pushedRegs = this.pushableRegs.slice(0, this.nUsedRegs - this.availableRegs.length);
+            this.pushedRegs = this.pushableRegs.slice(0, Math.max(0, this.nUsedRegs - this.availableRegs.length));
         }
         for (let i=0; i<this.neededRegs; i++) {
             if (i < this.availableRegs.length) {
@@ -52,9 +59,29 @@ module.exports = class RegManager {
         }
     }
 
+    _stackSize() {
+        return (this.neededRegs-this.nUsedRegs) + this.nLocals;
+    }
+
+    // Qword in the stack frame that can be used as a local variable
+    local(i) {
+        return `qword ${this.localAddr(i)}`;
+    }
+
+    // Address of a local variable (consecutive locals can hold an element)
+    localAddr(i) {
+        assert(i < this.nLocals);
+        return `[rsp + ${(this.neededRegs-this.nUsedRegs+i)*8}]`;
+    }
+
+    // Function argument passed in the stack (i=0 is the 7th argument)
+    stackArg(i) {
+        return `qword [rsp + ${(this._stackSize() + this.pushedRegs.length + 1 + i)*8}]`;
+    }
+
     _addHeader() {
-        if (this.neededRegs>this.nUsedRegs) {
-            this.code.unshift(`    sub rsp, ${(this.neededRegs-this.nUsedRegs)*8}`);
+        if (this._stackSize()>0) {
+            this.code.unshift(`    sub rsp, ${this._stackSize()*8}`);
         }
         for (let i=0; i<this.pushedRegs.length; i++) {
             this.code.unshift(`    push ${this.pushedRegs[i]}`);
@@ -62,8 +89,8 @@ module.exports = class RegManager {
     }
 
     _addgetFooter() {
-        if (this.neededRegs>this.nUsedRegs) {
-            this.code.push(`    add rsp, ${(this.neededRegs-this.nUsedRegs)*8}`);
+        if (this._stackSize()>0) {
+            this.code.push(`    add rsp, ${this._stackSize()*8}`);
         }
         for (let i=0; i<this.pushedRegs.length; i++) {
             this.code.push(`    pop ${this.pushedRegs[i]}`);
@@ -163,18 +190,28 @@ module.exports = class RegManager {
         }
 
         const params = [];
+        // The loaded operand goes first, so the others see the working registers after the load
         for (let i=0; i < inst.length; i++) {
-            if (typeof args[i] === "string") {
-                params.push(args[i]);
-            } else if (args[i]<this.nUsedRegs) {
-                params.push(this.regRefs[args[i]]);
-            } else if ((dLoad>=0)&&(args[i] == args[dLoad])) {
-                params.push(this._loadWr(args[i], inst[i].indexOf("I")>=0).reg);
+            if ((typeof args[i] !== "string")&&(args[i]>=this.nUsedRegs)&&(dLoad>=0)&&(args[i] == args[dLoad])) {
+                params[i] = this._loadWr(args[i], inst[i].indexOf("I")>=0).reg;
                 if (inst[i].indexOf("O")>=0) {
                     this.wrAssignments[this._indexOfWrAssignment(args[i])].modified = true;
                 }
+            }
+        }
+        for (let i=0; i < inst.length; i++) {
+            if (typeof params[i] !== "undefined") continue;
+            if (typeof args[i] === "string") {
+                params[i] = args[i];
+            } else if (args[i]<this.nUsedRegs) {
+                params[i] = this.regRefs[args[i]];
+            } else if (this._indexOfWrAssignment(args[i]) >= 0) {
+                // The value is cached in a working register, so the stack copy can be stale
+                const a = this.wrAssignments[this._indexOfWrAssignment(args[i])];
+                params[i] = a.reg;
+                if (inst[i].indexOf("O")>=0) a.modified = true;
             } else {
-                params.push(this.regRefs[args[i]]);
+                params[i] = this.regRefs[args[i]];
             }
         }
         this.code.push(`    ${instructionName} ${params.join(",")}`);
@@ -7,14 +7,39 @@ const renderFile = util.promisify(require("ejs").renderFile);
 
 const runningAsScript = !module.parent;
 
+// Minimum number of 64 bit words from which rawMMul and rawMSquare use
+// Karatsuba and a separate reduction instead of CIOS. Measured with
+// benchmark/benchmark.js
+const defaultKaratsuba = 0;
+
 const montgomeryBuilder = require("./montgomerybuilder");
+const lazyBuilder = require("./lazybuilder");
+const chainBuilder = require("./chainbuilder");
+const specialBuilder = require("./specialbuilder");
 
 class ZqBuilder {
-    constructor(q, name) {
+    constructor(q, name, target, karatsuba, special, nr) {
         const self = this;
         this.q=bigInt(q);
         this.n64 = Math.floor((this.q.bitLength() - 1) / 64)+1;
         this.name = name;
+        this.target = target || "asm";
+        // Special form primes (Goldilocks, pseudo-Mersenne) use their own reduction
+        // and keep the elements in normal form, that is R = 1 instead of 2^(64*n64).
+        // special = false forces Montgomery.
+        this.special = (special === false) ? null : specialBuilder.detect(this.q);
+        this.R = this.special ? bigInt.one : bigInt.one.shiftLeft(this.n64*64);
+        this.mulBuilder = this.special ? specialBuilder : montgomeryBuilder;
+        // 0 disables Karatsuba
+        this.karatsuba = (typeof karatsuba === "undefined") ? defaultKaratsuba : Number(karatsuba);
+        this.useKaratsuba = !this.special && (this.karatsuba > 0) && (this.n64 >= Math.max(2, this.karatsuba));
+        // Lazy reduction needs two spare bits: elements < 2q and sums < 4q fit in n64 words
+        this.hasLazy = !this.special && this.q.shiftLeft(2).lt(bigInt.one.shiftLeft(this.n64*64));
+        // Quadratic non residue of the extension kernels (rawF2Mul...), as a small signed
+        // integer. null when they are not generated.
+        this.f2Nr = (typeof nr === "undefined" || nr === null) ? null : this.smallNr(bigInt(nr));
+        // Signed limbs of 62 bits used by the inversion, with room for values in (-2q, 2q)
+        this.n62 = Math.floor((this.q.bitLength() + 8) / 62) + 1;
         this.bigInt = bigInt;
         this.lastTmp=0;
         this.global = {};
@@ -24,6 +49,71 @@ class ZqBuilder {
             return label+"_"+self.lastTmp;
         };
         this.montgomeryBuilder = montgomeryBuilder;
+        this.lazyBuilder = lazyBuilder;
+        this.chainBuilder = chainBuilder;
+        // C++ expression to call a dispatched kernel. The asm target goes through the
+        // table, the cpp target calls the inline function.
+        this.kernel = (fn) => (self.target == "asm") ? `${self.name}_kernels.${fn}` : `${self.name}_${fn}`;
+        // q-1 = 2^s * t with t odd, and the smallest quadratic non residue. Used by sqrt.
+        this.s = 0;
+        this.t = this.q.minus(1);
+        while (this.t.isEven() && !this.t.isZero()) {
+            this.t = this.t.shiftRight(1);
+            this.s++;
+        }
+        this.nqr = bigInt(2);
+        while ((this.s > 1) && !this.nqr.modPow(this.q.minus(1).shiftRight(1), this.q).eq(this.q.minus(1))) {
+            this.nqr = this.nqr.add(1);
+        }
+        // ejs gives the included templates a copy of the own properties only, so
+        // the helpers used by them are bound here
+        for (const m of ["constantElement", "constant62", "constantInv62", "dispatchedKernels"]) {
+            this[m] = this[m].bind(this);
+        }
+    }
+
+    // Kernels with CPU specific variants, called through <name>_kernels (dispatch.cpp.ejs).
+    // E stands for the <name>RawElement type.
+    dispatchedKernels() {
+        const k = [
+            ["rawMMul", "E r, const E a, const E b"],
+            ["rawMSquare", "E r, const E a"],
+            ["rawMMul1", "E r, const E a, uint64_t b"],
+            ["rawMMulAdd", "E r, const E a, const E b, const E c"],
+            ["rawMMulSub", "E r, const E a, const E b, const E c"],
+            ["rawMMulAddMMul", "E r, const E a, const E b, const E c, const E d"],
+            ["rawMMulSubMMul", "E r, const E a, const E b, const E c, const E d"],
+            ["rawMMul2x", "E r0, const E a0, const E b0, E r1, const E a1, const E b1"],
+            ["rawMMul4x", "E r0, const E a0, const E b0, E r1, const E a1, const E b1, E r2, const E a2, const E b2, E r3, const E a3, const E b3"],
+            ["rawMMulNStrided", "E *r, const E *a, const E *b, uint64_t n, int64_t strideR, int64_t strideA, int64_t strideB"],
+            ["rawMSquareNStrided", "E *r, const E *a, uint64_t n, int64_t strideR, int64_t strideA"],
+            ["rawMSquarePow2", "E r, const E a, uint64_t n"],
+            ["rawToMontgomery", "E r, const E &a"],
+            ["rawFromMontgomery", "E r, const E &a"],
+        ];
+        if (this.hasLazy) {
+            k.push(["rawLazyMMul", "E r, const E a, const E b"]);
+            k.push(["rawLazyMSquare", "E r, const E a"]);
+        }
+        if (this.f2Nr !== null) {
+            k.push(["rawF2Mul", "E *r, const E *a, const E *b"]);
+            k.push(["rawF2Square", "E *r, const E *a"]);
+        }
+        return k.map( ([fn, args]) => ({fn, args: args.replace(/\bE\b/g, this.name + "RawElement")}) );
+    }
+
+    // nr modulo q as a signed integer. The kernels keep the products of the real part
+    // in 2*n64 words, so |nr| must be small and they need the spare bits of hasLazy.
+    smallNr(nr) {
+        nr = nr.mod(this.q).add(this.q).mod(this.q);
+        if (nr.gt(this.q.shiftRight(1))) nr = nr.minus(this.q);
+        if (this.special) throw new Error("The quadratic extension kernels need a Montgomery field");
+        if (!this.hasLazy) throw new Error("The quadratic extension kernels need 4q < 2^(64*n64)");
+        if (nr.abs().gt(8)) throw new Error("The quadratic non residue must be in [-8, 8]: " + nr.toString());
+        if (!nr.add(this.q).modPow(this.q.minus(1).shiftRight(1), this.q).eq(this.q.minus(1))) {
+            throw new Error("nr is not a quadratic non residue: " + nr.toString());
+        }
+        return nr.toJSNumber();
     }
 
     constantElement(v) {
@@ -38,12 +128,32 @@ class ZqBuilder {
         return S;
     }
 
+    constant62(v) {
+        let S = "";
+        const mask = bigInt.one.shiftLeft(62).minus(1);
+        for (let i=0; i<this.n62; i++) {
+            if (i>0) S = S+",";
+            S = S + "0x" + v.shiftRight(i*62).and(mask).toString(16);
+        }
+        return S;
+    }
+
+    constantInv62(v) {
+        return "0x" + v.modInv(bigInt.one.shiftLeft(62)).toString(16);
+    }
+
 }
 
-async function buildField(q, name) {
-    const builder = new ZqBuilder(q, name);
+// target "asm" generates the x86_64 assembly backend. target "cpp" generates the
+// raw functions as inline C++ in the header and no .asm file.
+// karatsuba is the minimum number of words to use Karatsuba in the asm target.
+// special = false disables the special form reductions.
+// nr generates the kernels of the quadratic extension by nr (u^2 = nr).
+async function buildField(q, name, target, karatsuba, special, nr) {
+    const builder = new ZqBuilder(q, name, target, karatsuba, special, nr);
+    if ((builder.target != "asm")&&(builder.target != "cpp")) throw new Error("Invalid target: " + builder.target);
 
-    let asm = await renderFile(path.join(__dirname, "fr.asm.ejs"), builder);
+    let asm = (builder.target == "asm") ? await renderFile(path.join(__dirname, "fr.asm.ejs"), builder) : null;
     const cpp = await renderFile(path.join(__dirname, "fr.cpp.ejs"), builder);
     const hpp = await renderFile(path.join(__dirname, "fr.hpp.ejs"), builder);
 
@@ -53,7 +163,7 @@ async function buildField(q, name) {
 if (runningAsScript) {
     const fs = require("fs");
     var argv = require("yargs")
-        .usage("Usage: $0 -q [primeNum] -n [name] -oc [out .c file] -oh [out .h file] -oa [out .asm file]")
+        .usage("Usage: $0 -q [primeNum] -n [name] -oc [out .c file] -oh [out .h file] -oa [out .asm file] --target [asm|cpp] --karatsuba [min n64, 0 disables] --no-special --nr [quadratic non residue]")
         .demandOption(["q","n"])
         .alias("q", "prime")
         .alias("n", "name")
@@ -66,8 +176,8 @@ if (runningAsScript) {
     const cFileName =  (argv.oc) ? argv.oc : argv.name.toLowerCase() + ".cpp";
 
 
-    buildField(q, argv.name).then( (res) => {
-        fs.writeFileSync(asmFileName, res.asm, "utf8");
+    buildField(q, argv.name, argv.target, argv.karatsuba, argv.special, argv.nr).then( (res) => {
+        if (res.asm) fs.writeFileSync(asmFileName, res.asm, "utf8");
         fs.writeFileSync(hFileName, res.hpp, "utf8");
         fs.writeFileSync(cFileName, res.cpp, "utf8");
     });
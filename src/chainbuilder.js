@@ -0,0 +1,103 @@
+const bigInt=require("big-integer");
+
+// Exponentiations by constant exponents (q-2, (q-1)/2, ...) generated as
+// straight-line C++ at field generation time.
+//
+// The exponent is scanned from the top with a sliding window of odd powers
+// a^1, a^3, ..., a^(2^k-1). k is chosen to minimize the number of
+// multiplications, the squarings are about the same for every k. Consecutive
+// squarings are merged in a single rawMSquarePow2 call.
+
+module.exports.buildChain = buildChain;
+module.exports.buildPow = buildPow;
+
+// Returns {k, nMuls, nSquares, steps}. steps is a list of {sq: n} and {mul: i}
+// to apply after r = a^(2*first+1), where {mul: i} multiplies by a^(2*i+1).
+function buildChainK(e, k) {
+    const bits = e.toString(2);
+    const steps = [];
+    let first = -1;
+    let nMuls = 0;
+    let nSquares = 0;
+    let pendingSq = 0;
+    let i = 0;
+    while (i < bits.length) {
+        if (bits[i] == "0") {
+            pendingSq++;
+            i++;
+            continue;
+        }
+        // Longest window of up to k bits that ends in a one
+        let j = Math.min(i + k, bits.length) - 1;
+        while (bits[j] == "0") j--;
+        const v = parseInt(bits.slice(i, j+1), 2);
+        if (first < 0) {
+            first = (v-1)/2;
+        } else {
+            pendingSq += j-i+1;
+            steps.push({sq: pendingSq});
+            steps.push({mul: (v-1)/2});
+            nSquares += pendingSq;
+            nMuls ++;
+        }
+        pendingSq = 0;
+        i = j+1;
+    }
+    if (pendingSq) {
+        steps.push({sq: pendingSq});
+        nSquares += pendingSq;
+    }
+    // The table needs a square and 2^(k-1)-1 multiplications
+    const nTable = (1 << (k-1)) - 1;
+    return {k, first, nMuls: nMuls + nTable, nSquares: nSquares + (k>1 ? 1 : 0), steps};
+}
+
+function buildChain(e) {
+    e = bigInt(e);
+    let best = null;
+    for (let k=1; k<=8; k++) {
+        const c = buildChainK(e, k);
+        if ((!best)||(c.nMuls + c.nSquares < best.nMuls + best.nSquares)) best = c;
+    }
+    return best;
+}
+
+// C++ function fn(r, a) that computes r = a^e in Montgomery form. r and a can be the same.
+// oneConst is the name of the Montgomery one, used if e is 0. kernel(f) returns the
+// expression to call the multiplication f, <name>_f by default.
+function buildPow(name, fn, e, oneConst, isStatic, kernel) {
+    e = bigInt(e);
+    kernel = kernel || ((f) => `${name}_${f}`);
+    const code = [];
+    const E = `${name}RawElement`;
+    code.push(`${isStatic ? "static " : ""}void ${fn}(${E} r, const ${E} a) {`);
+    if (e.isZero()) {
+        code.push(`    ${name}_rawCopy(r, ${oneConst});`);
+        code.push("}");
+        return code.join("\n");
+    }
+    const chain = buildChain(e);
+    const nTable = 1 << (chain.k-1);
+    code.push(`    // ${chain.nSquares} squarings and ${chain.nMuls} multiplications, window of ${chain.k} bits`);
+    code.push(`    ${E} t[${nTable}];`);
+    code.push(`    ${name}_rawCopy(t[0], a);`);
+    if (nTable > 1) {
+        code.push(`    ${E} a2;`);
+        code.push(`    ${kernel("rawMSquare")}(a2, a);`);
+        code.push(`    for (int i=1; i<${nTable}; i++) ${kernel("rawMMul")}(t[i], t[i-1], a2);`);
+    }
+    code.push(`    ${name}_rawCopy(r, t[${chain.first}]);`);
+    for (const s of chain.steps) {
+        if (typeof s.sq !== "undefined") {
+            if (s.sq == 1) {
+                code.push(`    ${kernel("rawMSquare")}(r, r);`);
+            } else {
+                code.push(`    ${kernel("rawMSquarePow2")}(r, r, ${s.sq});`);
+            }
+        } else {
+            code.push(`    ${kernel("rawMMul")}(r, r, t[${s.mul}]);`);
+        }
+    }
+    code.push("}");
+    return code.join("\n");
+}
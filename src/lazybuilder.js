@@ -0,0 +1,94 @@
+const AsmBuilder = require("./asmbuilder");
+
+// Kernels for the lazy reduction mode. The elements are kept in [0, 2q) and
+// 4q < 2^(64*n64), so the sums never overflow.
+//
+// The final correction is branchless: the corrected value is computed in the
+// registers and the original one (already stored in the result) is selected
+// back with cmov, which does not modify the flags.
+
+module.exports.buildLazyAdd = buildLazyAdd;
+module.exports.buildLazySub = buildLazySub;
+module.exports.buildLazyNeg = buildLazyNeg;
+module.exports.buildLazyReduce = buildLazyReduce;
+
+function getN64(q) {
+    return Math.floor((q.bitLength() - 1) / 64)+1;
+}
+
+// Stores the registers 0..n64-1 in the result
+function storeResult(c, n64) {
+    for (let i=0; i<n64; i++) {
+        c.op("mov", `[rdi + ${i*8}]`, i);
+    }
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b.  r = a + b - (a + b >= 2q ? 2q : 0)
+function buildLazyAdd(fn, q) {
+    const n64 = getN64(q);
+    const c = new AsmBuilder(fn, n64);
+    for (let i=0; i<n64; i++) {
+        c.op("mov", i, `[rsi + ${i*8}]`);
+        c.op(i==0 ? "add" : "adc", i, `[rdx + ${i*8}]`);
+    }
+    storeResult(c, n64);
+    for (let i=0; i<n64; i++) {
+        c.op(i==0 ? "sub" : "sbb", i, `[q2 + ${i*8}]`);
+    }
+    for (let i=0; i<n64; i++) {
+        c.op("cmovc", i, `[rdi + ${i*8}]`);
+    }
+    storeResult(c, n64);
+    c.flushWr(true);
+    return c.getCode();
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b.  r = a - b + (a < b ? 2q : 0)
+function buildLazySub(fn, q) {
+    return buildLazySubTemplate(fn, q, function(c, i) {
+        c.op("mov", i, `[rsi + ${i*8}]`);
+        c.op(i==0 ? "sub" : "sbb", i, `[rdx + ${i*8}]`);
+    });
+}
+
+// Params: rdi <= r, rsi <= a.  r = 2q - a if a != 0, r = 0 otherwise
+function buildLazyNeg(fn, q) {
+    return buildLazySubTemplate(fn, q, function(c, i) {
+        c.op("mov", i, "0");
+        c.op(i==0 ? "sub" : "sbb", i, `[rsi + ${i*8}]`);
+    });
+}
+
+function buildLazySubTemplate(fn, q, subDigit) {
+    const n64 = getN64(q);
+    const c = new AsmBuilder(fn, n64);
+    for (let i=0; i<n64; i++) subDigit(c, i);
+    c.code.push("    sbb rcx, rcx");
+    storeResult(c, n64);
+    for (let i=0; i<n64; i++) {
+        c.op(i==0 ? "add" : "adc", i, `[q2 + ${i*8}]`);
+    }
+    c.code.push("    test rcx, rcx");
+    for (let i=0; i<n64; i++) {
+        c.op("cmovz", i, `[rdi + ${i*8}]`);
+    }
+    storeResult(c, n64);
+    c.flushWr(true);
+    return c.getCode();
+}
+
+// Params: rdi <= r, rsi <= a.  r = a - (a >= q ? q : 0)
+function buildLazyReduce(fn, q) {
+    const n64 = getN64(q);
+    const c = new AsmBuilder(fn, n64);
+    for (let i=0; i<n64; i++) {
+        c.op("mov", i, `[rsi + ${i*8}]`);
+        c.op(i==0 ? "sub" : "sbb", i, `[q + ${i*8}]`);
+    }
+    for (let i=0; i<n64; i++) {
+        c.op("cmovc", i, `[rsi + ${i*8}]`);
+    }
+    storeResult(c, n64);
+    c.flushWr(true);
+    return c.getCode();
+}
@@ -1,5 +1,6 @@
 const bigInt = require("big-integer");
 const AsmBuilder = require("./asmbuilder");
+const assert = require("assert");
 
 // Important Documentation:
 // https://www.microsoft.com/en-us/research/wp-content/uploads/1998/06/97Acar.pdf
@@ -11,12 +12,49 @@ module.exports.buildMul = buildMul;
 module.exports.buildSquare = buildSquare;
 module.exports.buildMul1 = buildMul1;
 module.exports.buildFromMontgomery = buildFromMontgomery;
-
-function templateMontgomery(fn, q, upperLoop) {
+module.exports.buildMulN = buildMulN;
+module.exports.buildMul2x = buildMul2x;
+module.exports.buildMul4x = buildMul4x;
+module.exports.buildSquareN = buildSquareN;
+module.exports.buildSquarePow2 = buildSquarePow2;
+module.exports.buildMulAdd = buildMulAdd;
+module.exports.buildMulSub = buildMulSub;
+module.exports.buildMulAddMul = buildMulAddMul;
+module.exports.buildMulSubMul = buildMulSubMul;
+module.exports.buildLazyMul = buildLazyMul;
+module.exports.buildLazySquare = buildLazySquare;
+module.exports.buildMulKaratsuba = buildMulKaratsuba;
+module.exports.buildSquareKaratsuba = buildSquareKaratsuba;
+module.exports.buildF2Mul = buildF2Mul;
+module.exports.buildF2Square = buildF2Square;
+// Shared with specialbuilder.js
+module.exports.finalReduction = finalReduction;
+module.exports.mulSchoolbook = mulSchoolbook;
+
+// If loop is defined, the multiplication is repeated over arrays of elements.
+// loop.setup(c) saves the arguments in the locals before the loop starts and
+// loop.next(c) advances the pointers. local(0) must keep the number of elements.
+//
+// If fused is defined, the function computes a*b+c like expressions with a
+// single final reduction. fused.setup(c) saves the extra arguments in
+// fused.nLocals locals, fused.upperLoop (optional) accumulates a second product
+// in every row, fused.tail(c, params) updates the not reduced result and
+// fused.restore(c) recovers rdi. The value must be < 3q before the reduction.
+//
+// If lazy is set the final reduction is skipped. With 4q < 2^(64*n64) and both
+// operands < 2q the result is < 2q.
+//
+// If streams is defined, the function computes streams.n independent products
+// one after the other in the same frame, so the out of order core can overlap
+// them. streams.setup(c) saves the arguments in streams.nLocals locals and
+// streams.select(c, k) loads the pointers of the k-th product in rdi, rsi and
+// rcx. It can not be combined with loop or fused.
+function templateMontgomery(fn, q, upperLoop, loop, fused, lazy, streams) {
 
 
     const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
-    const canOptimizeConsensys = q.shiftRight((n64-1)*64).leq( bigInt.one.shiftLeft(64).minus(1).shiftRight(1).minus(1) );
+    // Two products in a row need an extra word even if q has spare bits
+    const canOptimizeConsensys = !(fused && fused.upperLoop) && q.shiftRight((n64-1)*64).leq( bigInt.one.shiftLeft(64).minus(1).shiftRight(1).minus(1) );
     const base = bigInt.one.shiftLeft(64);
     const np64 = base.minus(q.modInv(base));
     const t=4;
@@ -24,72 +62,116 @@ function templateMontgomery(fn, q, upperLoop) {
     const params = {q, n64, t, canOptimizeConsensys};
 
 
-    const c = new AsmBuilder(fn, 4 + n64 + 1 + (canOptimizeConsensys ? 0 : 1));
+    const c = new AsmBuilder(fn, 4 + n64 + 1 + (canOptimizeConsensys ? 0 : 1), (loop ? 4 : 0) + (fused ? fused.nLocals : 0) + (streams ? streams.nLocals : 0));
 
-    c.op("mov","rcx","rdx");   // rdx is needed for multiplications so keep it in cx
+    if (loop) {
+        loop.setup(c);
+        c.code.push(`    cmp ${c.local(0)}, 0`);
+        c.code.push(`    je ${fn}_end`);
+    } else if (streams) {
+        streams.setup(c);
+    } else {
+        if (fused) fused.setup(c, params);
+        c.op("mov","rcx","rdx");   // rdx is needed for multiplications so keep it in cx
+    }
 
     // c.op("mov", 2, `0x${np64.toString(16)}`);
     c.op("mov", 2, "[ np ]");
-    c.op("xor", 3, 3);
+    if (loop) c.code.push(fn+ "_loop:");
+
+    const nStreams = streams ? streams.n : 1;
+    for (let k=0; k<nStreams; k++) {
+        const sfn = streams ? `${fn}_${k}` : fn;
+        if (streams) {
+            c.flushWr(true);
+            streams.select(c, k);
+        }
+        c.op("xor", 3, 3);
 
-    c.code.push("");
-    for (let i=0; i<n64; i++) {
+        c.code.push("");
+        for (let i=0; i<n64; i++) {
 
-        upperLoop(c, params, i);
+            upperLoop(c, params, i);
+            if (fused && fused.upperLoop) fused.upperLoop(c, params, i);
 
-        c.code.push("; SecondLoop");
-        c.op("mov", "rdx", 2);
-        c.op("mulx", 0, "rdx", t);
-        c.op("mulx", 1, 0, "[q]");
-        c.op("adcx", 0, t);
-        for (let j=1; j<n64; j++) {
-            c.op("mulx", (j+1)%2, t+j-1, `[q +${j*8}]`);
-            c.op("adcx", t+j-1, j%2);
-            c.op("adox", t+j-1, t+j);
-        }
-        c.op("mov", t+n64-1, 3);
-        c.op("adcx", t+n64-1, n64%2);
-        c.op("adox", t+n64-1, t+n64);
-        if (!canOptimizeConsensys) {
-            c.op("mov", t+n64, 3);
-            c.op("adcx", t+n64, 3);
-            c.op("adox", t+n64, t+n64+1);
-        }
+            c.code.push("; SecondLoop");
+            c.op("mov", "rdx", 2);
+            c.op("mulx", 0, "rdx", t);
+            c.op("mulx", 1, 0, "[q]");
+            c.op("adcx", 0, t);
+            for (let j=1; j<n64; j++) {
+                c.op("mulx", (j+1)%2, t+j-1, `[q +${j*8}]`);
+                c.op("adcx", t+j-1, j%2);
+                c.op("adox", t+j-1, t+j);
+            }
+            c.op("mov", t+n64-1, 3);
+            c.op("adcx", t+n64-1, n64%2);
+            c.op("adox", t+n64-1, t+n64);
+            if (!canOptimizeConsensys) {
+                c.op("mov", t+n64, 3);
+                c.op("adcx", t+n64, 3);
+                c.op("adox", t+n64, t+n64+1);
+            }
 
-        c.code.push("");
-    }
+            c.code.push("");
+        }
 
-    c.code.push(";comparison");
-    c.flushWr(false);
-    if (!canOptimizeConsensys) {
-        c.op("test", t+n64, t+n64);
-        c.code.push(`jnz ${fn}_sq`);
-    }
-    for (let i=n64-1; i>=0; i--) {
-        c.op("cmp", t+i, `[q + ${i*8}]`);
-        c.code.push(`    jc ${fn}_done`);
-        c.code.push(`    jnz ${fn}_sq`);
-    }
+        if (fused) fused.tail(c, params);
 
-    c.code.push(fn+ "_sq:");
-    c.flushWr(true);
-    for (let i=0; i<n64; i++) {
-        c.op(i==0 ? "sub" : "sbb", t+i, `[q +${i*8}]`);
+        // A fused result is < 3q and needs up to two subtractions
+        const hasTop = fused || !canOptimizeConsensys;
+        const nReductions = lazy ? 0 : (fused ? 2 : 1);
+        finalReduction(c, sfn, t, n64, hasTop ? t+n64 : -1, nReductions);
+        if (fused) fused.restore(c);
+        for (let i=0; i<n64; i++) {
+            c.op("mov" ,  `[rdi + ${i*8}]`, t+i);
+        }
     }
-    c.flushWr(true);
 
-    c.code.push(fn+ "_done:");
-    c.flushWr(true);
-    c.wrAssignments = [];
-    for (let i=0; i<n64; i++) {
-        c.op("mov" ,  `[rdi + ${i*8}]`, t+i);
+    if (loop) {
+        c.flushWr(true);
+        loop.next(c);
+        c.code.push(`    dec ${c.local(0)}`);
+        c.code.push(`    jnz ${fn}_loop`);
+        c.code.push(fn+ "_end:");
     }
 
     return c.getCode();
 }
 
 
-function buildMul(fn, q) {
+// Substracts q from (top:t) while it is >= q. top is -1 if the value fits in
+// the n64 words.
+function finalReduction(c, fn, t, n64, top, nReductions) {
+    for (let k=0; k<nReductions; k++) {
+        const sfx = k ? `${k}` : "";
+        c.code.push(";comparison");
+        c.flushWr(false);
+        if (top >= 0) {
+            c.op("test", top, top);
+            c.code.push(`jnz ${fn}_sq${sfx}`);
+        }
+        for (let i=n64-1; i>=0; i--) {
+            c.op("cmp", t+i, `[q + ${i*8}]`);
+            c.code.push(`    jc ${fn}_done${sfx}`);
+            c.code.push(`    jnz ${fn}_sq${sfx}`);
+        }
+
+        c.code.push(fn+ `_sq${sfx}:`);
+        c.flushWr(true);
+        for (let i=0; i<n64; i++) {
+            c.op(i==0 ? "sub" : "sbb", t+i, `[q +${i*8}]`);
+        }
+        if ((top >= 0)&&(k+1 < nReductions)) c.op("sbb", top, "0");
+        c.flushWr(true);
+
+        c.code.push(fn+ `_done${sfx}:`);
+        c.flushWr(true);
+        c.wrAssignments = [];
+    }
+}
+
+function buildMul(fn, q, loop, fused, lazy, streams) {
     return templateMontgomery(fn, q, function mulUpperLoop(c, params, i) {
         const {t, n64, canOptimizeConsensys} = params;
         c.code.push("; FirstLoop");
@@ -128,6 +210,208 @@ function buildMul(fn, q) {
                 c.op("adcx", t+n64, 3);
             }
         }
+    }, loop, fused, lazy, streams);
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b, rcx <= n, r8 <= strideR, r9 <= strideA, [stack] <= strideB
+const mulNLoop = {
+    setup: function(c) {
+        c.code.push(`    mov ${c.local(0)}, rcx`);
+        c.code.push(`    mov ${c.local(1)}, r8`);
+        c.code.push(`    mov ${c.local(2)}, r9`);
+        c.code.push(`    mov rax, ${c.stackArg(0)}`);
+        c.code.push(`    mov ${c.local(3)}, rax`);
+        c.code.push("    mov rcx, rdx");
+    },
+    next: function(c) {
+        c.code.push(`    add rdi, ${c.local(1)}`);
+        c.code.push(`    add rsi, ${c.local(2)}`);
+        c.code.push(`    add rcx, ${c.local(3)}`);
+    }
+};
+
+// Params: rdi <= r, rsi <= a, rdx <= n, rcx <= strideR, r8 <= strideA
+const squareNLoop = {
+    setup: function(c) {
+        c.code.push(`    mov ${c.local(0)}, rdx`);
+        c.code.push(`    mov ${c.local(1)}, rcx`);
+        c.code.push(`    mov ${c.local(2)}, r8`);
+    },
+    next: function(c) {
+        c.code.push(`    add rdi, ${c.local(1)}`);
+        c.code.push(`    add rsi, ${c.local(2)}`);
+    }
+};
+
+// Params: rdi <= r, rsi <= a, rdx <= n.  r = a^(2^n). After the first square the result is squared in place
+const squarePow2Loop = {
+    setup: function(c) {
+        c.code.push(`    mov ${c.local(0)}, rdx`);
+    },
+    next: function(c) {
+        c.code.push("    mov rsi, rdi");
+    }
+};
+
+// Params: rdi <= r0, rsi <= a0, rdx <= b0, rcx <= r1, r8 <= a1, r9 <= b1
+const mul2xStreams = {
+    n: 2,
+    nLocals: 3,
+    setup: function(c) {
+        c.code.push(`    mov ${c.local(0)}, rcx`);
+        c.code.push(`    mov ${c.local(1)}, r8`);
+        c.code.push(`    mov ${c.local(2)}, r9`);
+        c.code.push("    mov rcx, rdx");
+    },
+    select: function(c, k) {
+        if (k == 0) return;
+        c.code.push(`    mov rdi, ${c.local(0)}`);
+        c.code.push(`    mov rsi, ${c.local(1)}`);
+        c.code.push(`    mov rcx, ${c.local(2)}`);
+    }
+};
+
+// Params: the same as mul2x plus r2, a2, b2, r3, a3 and b3 in the stack
+const mul4xStreams = {
+    n: 4,
+    nLocals: 3,
+    setup: mul2xStreams.setup,
+    select: function(c, k) {
+        if (k < 2) return mul2xStreams.select(c, k);
+        c.code.push(`    mov rdi, ${c.stackArg(3*(k-2))}`);
+        c.code.push(`    mov rsi, ${c.stackArg(3*(k-2)+1)}`);
+        c.code.push(`    mov rcx, ${c.stackArg(3*(k-2)+2)}`);
+    }
+};
+
+function buildMul2x(fn, q) {
+    return buildMul(fn, q, undefined, undefined, false, mul2xStreams);
+}
+
+function buildMul4x(fn, q) {
+    return buildMul(fn, q, undefined, undefined, false, mul4xStreams);
+}
+
+function buildMulN(fn, q) {
+    return buildMul(fn, q, mulNLoop);
+}
+
+function buildSquareN(fn, q) {
+    return buildSquare(fn, q, squareNLoop);
+}
+
+function buildSquarePow2(fn, q) {
+    return buildSquare(fn, q, squarePow2Loop);
+}
+
+// Adds the element pointed by local(0) to the result
+function fusedAddTail(c, params) {
+    const {t, n64, canOptimizeConsensys} = params;
+    c.code.push("; Add c");
+    if (canOptimizeConsensys) c.op("mov", t+n64, 3);
+    c.code.push(`    mov rdx, ${c.local(0)}`);
+    for (let i=0; i<n64; i++) {
+        c.op(i==0 ? "add" : "adc", t+i, `[rdx + ${i*8}]`);
+    }
+    c.op("adc", t+n64, "0");
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b, rcx <= c.  r = a*b + c
+const mulAddFused = {
+    nLocals: 1,
+    setup: function(c) {
+        c.code.push(`    mov ${c.local(0)}, rcx`);
+    },
+    tail: fusedAddTail,
+    restore: function() {}
+};
+
+// Params: rdi <= r, rsi <= a, rdx <= b, rcx <= c.  r = a*b - c
+const mulSubFused = {
+    nLocals: 1,
+    setup: function(c) {
+        c.code.push(`    mov ${c.local(0)}, rcx`);
+    },
+    tail: function(c, params) {
+        const {t, n64, canOptimizeConsensys} = params;
+        // t + q - c is positive and < 3q
+        c.code.push("; Add q and substract c");
+        if (canOptimizeConsensys) c.op("mov", t+n64, 3);
+        for (let i=0; i<n64; i++) {
+            c.op(i==0 ? "add" : "adc", t+i, `[q + ${i*8}]`);
+        }
+        c.op("adc", t+n64, "0");
+        c.code.push(`    mov rdx, ${c.local(0)}`);
+        for (let i=0; i<n64; i++) {
+            c.op(i==0 ? "sub" : "sbb", t+i, `[rdx + ${i*8}]`);
+        }
+        c.op("sbb", t+n64, "0");
+    },
+    restore: function() {}
+};
+
+function buildMulAdd(fn, q) {
+    return buildMul(fn, q, undefined, mulAddFused);
+}
+
+function buildMulSub(fn, q) {
+    return buildMul(fn, q, undefined, mulSubFused);
+}
+
+// Accumulates c[i]*d in the row. local(1) keeps c and rdi points to d
+function fusedSecondProduct(c, params, i) {
+    const {t, n64} = params;
+    c.code.push("; SecondProduct");
+    c.code.push(`    mov rdx, ${c.local(1)}`);
+    c.code.push(`    mov rdx, [rdx + ${i*8}]`);
+    for (let j=0; j<n64; j++) {
+        c.op("mulx", 1, 0, `[rdi +${j*8}]`);
+        c.op("adcx", t+j, 0);
+        c.op("adox", t+j+1, 1);
+    }
+    c.op("adcx", t+n64, 3);
+    c.op("adcx", t+n64+1, 3);
+    c.op("adox", t+n64+1, 3);
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b, rcx <= c, r8 <= d.  r = a*b + c*d
+function buildMulAddMul(fn, q) {
+    return buildMul(fn, q, undefined, {
+        nLocals: 2,
+        setup: function(c) {
+            c.code.push(`    mov ${c.local(0)}, rdi`);
+            c.code.push(`    mov ${c.local(1)}, rcx`);
+            c.code.push("    mov rdi, r8");
+        },
+        upperLoop: fusedSecondProduct,
+        tail: function() {},
+        restore: function(c) {
+            c.code.push(`    mov rdi, ${c.local(0)}`);
+        }
+    });
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b, rcx <= c, r8 <= d.  r = a*b - c*d
+// It computes a*b + c*(q-d). q-d is kept in the locals.
+function buildMulSubMul(fn, q) {
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    return buildMul(fn, q, undefined, {
+        nLocals: 2 + n64,
+        setup: function(c) {
+            c.code.push(`    mov ${c.local(0)}, rdi`);
+            c.code.push(`    mov ${c.local(1)}, rcx`);
+            for (let i=0; i<n64; i++) {
+                c.code.push(`    mov rax, [q + ${i*8}]`);
+                c.code.push(`    ${i==0 ? "sub" : "sbb"} rax, [r8 + ${i*8}]`);
+                c.code.push(`    mov ${c.local(2+i)}, rax`);
+            }
+            c.code.push(`    lea rdi, ${c.localAddr(2)}`);
+        },
+        upperLoop: fusedSecondProduct,
+        tail: function() {},
+        restore: function(c) {
+            c.code.push(`    mov rdi, ${c.local(0)}`);
+        }
     });
 }
 
@@ -216,7 +500,7 @@ function buildSquare(fn, q) {
 */
 
 
-function buildSquare(fn, q) {
+function buildSquare(fn, q, loop, lazy) {
     return templateMontgomery(fn, q, function mulUpperLoop(c, params, i) {
         const {t, n64, canOptimizeConsensys} = params;
         c.code.push("; FirstLoop");
@@ -255,7 +539,299 @@ function buildSquare(fn, q) {
                 c.op("adcx", t+n64, 3);
             }
         }
-    });
+    }, loop, undefined, lazy);
+}
+
+function buildLazyMul(fn, q) {
+    return buildMul(fn, q, undefined, undefined, true);
+}
+
+function buildLazySquare(fn, q) {
+    return buildSquare(fn, q, undefined, true);
+}
+
+
+// Karatsuba multiplication followed by a separate Montgomery reduction.
+//
+// With a = a1*B^h + a0 and b = b1*B^h + b0 (B = 2^64, h = n64/2 rounded down):
+//   a*b = z2*B^2h + (sa*sb - z0 - z2)*B^h + z0
+// where z0 = a0*b0, z2 = a1*b1, sa = a0+a1 and sb = b0+b1. sa and sb can have
+// an extra bit, so sa*sb is computed with k words (k = n64-h) and corrected.
+// The 2*n64 word product is kept in the stack and reduced word by word.
+//
+// Params: rdi <= r, rsi <= a, rdx <= b (rsi for the square)
+function templateKaratsuba(fn, q, square) {
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    const h = Math.floor(n64/2);
+    const k = n64 - h;
+    const t = 4;
+
+    // Locals: Z (product), SA, SB (k words and the carry) and M (2k+1 words)
+    const Z = 0, SA = 2*n64, SB = SA + k+1, M = SB + k+1;
+    const c = new AsmBuilder(fn, 4 + n64 + 1, M + 2*k+1);
+    const L = (base, i) => c.local(base+i);
+
+    c.op("mov", "rcx", square ? "rsi" : "rdx");
+
+    // z0 and z2
+    mulSchoolbook(c, t, (i) => L(Z, i), (i) => `[rsi + ${i*8}]`, (j) => `[rcx + ${j*8}]`, h, h);
+    mulSchoolbook(c, t, (i) => L(Z, 2*h+i), (i) => `[rsi + ${(h+i)*8}]`, (j) => `[rcx + ${(h+j)*8}]`, k, k);
+
+    // sa = a0 + a1, sb = b0 + b1
+    for (const [S, ptr] of [[SA, "rsi"], [SB, "rcx"]]) {
+        for (let i=0; i<k; i++) {
+            c.code.push(`    mov rax, [${ptr} + ${(h+i)*8}]`);
+            c.code.push(`    ${i==0 ? "add" : "adc"} rax, ${i<h ? `[${ptr} + ${i*8}]` : "0"}`);
+            c.code.push(`    mov ${L(S, i)}, rax`);
+        }
+        c.code.push("    mov rax, 0");
+        c.code.push("    adc rax, 0");
+        c.code.push(`    mov ${L(S, k)}, rax`);
+    }
+
+    // M = sa*sb
+    mulSchoolbook(c, t, (i) => L(M, i), (i) => L(SA, i), (j) => L(SB, j), k, k);
+    c.code.push(`    mov ${L(M, 2*k)}, 0`);
+    for (const [S1, S2] of [[SA, SB], [SB, SA]]) {
+        c.code.push("; Add the carry of one sum times the other one");
+        c.op("mov", 2, L(S1, k));
+        c.op("neg", 2);
+        for (let i=0; i<k; i++) {
+            c.op("mov", t+i, L(S2, i));
+            c.op("and", t+i, 2);
+        }
+        for (let i=0; i<k; i++) {
+            c.op(i==0 ? "add" : "adc", L(M, k+i), t+i);
+        }
+        c.code.push(`    adc ${L(M, 2*k)}, 0`);
+    }
+    c.code.push(`    mov rax, ${L(SA, k)}`);
+    c.code.push(`    and rax, ${L(SB, k)}`);
+    c.code.push(`    add ${L(M, 2*k)}, rax`);
+
+    // M = M - z0 - z2
+    for (const [base, len] of [[Z, 2*h], [Z + 2*h, 2*k]]) {
+        for (let i=0; i<=2*k; i++) {
+            c.code.push(`    mov rax, ${L(M, i)}`);
+            c.code.push(`    ${i==0 ? "sub" : "sbb"} rax, ${i<len ? L(base, i) : "0"}`);
+            c.code.push(`    mov ${L(M, i)}, rax`);
+        }
+    }
+
+    // Z = Z + M*B^h
+    for (let i=0; i<=2*k; i++) {
+        c.code.push(`    mov rax, ${L(Z, h+i)}`);
+        c.code.push(`    ${i==0 ? "add" : "adc"} rax, ${L(M, i)}`);
+        c.code.push(`    mov ${L(Z, h+i)}, rax`);
+    }
+    for (let i=h+2*k+1; i<2*n64; i++) {
+        c.code.push(`    adc ${L(Z, i)}, 0`);
+    }
+
+    reduceWide(c, fn, t, n64, (i) => L(Z, i), 1);
+    for (let i=0; i<n64; i++) {
+        c.op("mov" ,  `[rdi + ${i*8}]`, t+i);
+    }
+
+    return c.getCode();
+}
+
+// Montgomery reduction of the 2*n64 words z(i) to t..t+n64-1, followed by
+// nReductions substractions of q. The same rows than templateMontgomery, but the
+// top word is added from z and the carry of each row is kept in t+n64.
+function reduceWide(c, fn, t, n64, z, nReductions) {
+    const cy = t+n64;
+    c.code.push("; Reduction");
+    c.op("xor", 3, 3);
+    c.op("mov", 2, "[ np ]");
+    for (let j=0; j<n64; j++) {
+        c.op("mov", t+j, z(j));
+    }
+    c.op("mov", cy, 3);
+    for (let i=0; i<n64; i++) {
+        c.op("mov", "rdx", 2);
+        c.op("mulx", 0, "rdx", t);
+        c.op("mulx", 1, 0, "[q]");
+        c.op("adcx", 0, t);
+        for (let j=1; j<n64; j++) {
+            c.op("mulx", (j+1)%2, t+j-1, `[q +${j*8}]`);
+            c.op("adcx", t+j-1, j%2);
+            c.op("adox", t+j-1, t+j);
+        }
+        c.op("mov", t+n64-1, cy);
+        c.op("adcx", t+n64-1, n64%2);
+        c.op("adox", t+n64-1, z(n64+i));
+        c.op("mov", cy, 3);
+        c.op("adcx", cy, 3);
+        c.op("adox", cy, 3);
+        c.code.push("");
+    }
+
+    finalReduction(c, fn, t, n64, cy, nReductions);
+}
+
+// dst = a*b with na x nb words. The accumulator is a window of nb+1 registers
+// from t that rotates one position in every row.
+function mulSchoolbook(c, t, dst, a, b, na, nb) {
+    const acc = (i, j) => t + ((i+j) % (nb+1));
+    c.op("xor", 3, 3);
+    for (let i=0; i<na; i++) {
+        c.op("mov", "rdx", a(i));
+        if (i==0) {
+            c.op("mulx", 0, acc(0, 0), b(0));
+            for (let j=1; j<nb; j++) {
+                c.op("mulx", j%2, acc(0, j), b(j));
+                c.op("adcx", acc(0, j), (j-1)%2);
+            }
+            c.op("mov", acc(0, nb), 3);
+            c.op("adcx", acc(0, nb), (nb-1)%2);
+        } else {
+            c.op("mov", acc(i, nb), 3);
+            for (let j=0; j<nb; j++) {
+                c.op("mulx", 1, 0, b(j));
+                c.op("adcx", acc(i, j), 0);
+                c.op("adox", acc(i, j+1), 1);
+            }
+            c.op("adcx", acc(i, nb), 3);
+        }
+        c.op("mov", dst(i), acc(i, 0));
+    }
+    for (let j=1; j<=nb; j++) {
+        c.op("mov", dst(na-1+j), acc(na-1, j));
+    }
+}
+
+function buildMulKaratsuba(fn, q) {
+    return templateKaratsuba(fn, q, false);
+}
+
+function buildSquareKaratsuba(fn, q) {
+    return templateKaratsuba(fn, q, true);
+}
+
+// Reductions needed after the Montgomery reduction of a value <= tMax
+function wideReductions(q, n64, tMax) {
+    const R = bigInt.one.shiftLeft(64*n64);
+    assert(tMax.lt(R.square()));
+    const max = tMax.add(R.minus(1).multiply(q)).divide(R);
+    return max.divide(q).toJSNumber();
+}
+
+// Product in the quadratic extension Fq[u]/(u^2 - nr), with a small nr baked in.
+// An element is two consecutive field elements x0 + x1*u, both < q.
+//
+//   r0 = a0*b0 + nr*a1*b1
+//   r1 = (a0 + a1)*(b0 + b1) - a0*b0 - a1*b1
+//
+// The double width products are combined before they are reduced (Karatsuba with
+// lazy reduction), so it takes 3 products and 2 reductions. A negative nr adds
+// |nr|*q^2 to keep r0 positive. The square with nr = -1 takes 2 products:
+// r0 = (a0 + a1)*(a0 - a1 + q) and r1 = 2*a0*a1. Needs 4q < 2^(64*n64).
+//
+// Params: rdi <= r, rsi <= a, rdx <= b (rsi for the square)
+function templateF2(fn, q, nr, square) {
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    const t = 4;
+    const absNr = Math.abs(nr);
+    const q1 = q.minus(1);
+
+    // Locals: Z0, Z2 and M (products) and SA, SB (sums)
+    const Z0 = 0, Z2 = 2*n64, M = 4*n64, SA = 6*n64, SB = 7*n64;
+    const c = new AsmBuilder(fn, 4 + n64 + 1, 8*n64);
+    const L = (base, i) => c.local(base+i);
+    const A = (k, i) => `[rsi + ${(k*n64+i)*8}]`;
+    const B = (k, i) => `[rcx + ${(k*n64+i)*8}]`;
+
+    // S = x + y. The sums are < 2q, so there is no carry
+    function sum(S, x, y) {
+        for (let i=0; i<n64; i++) {
+            c.code.push(`    mov rax, ${x(i)}`);
+            c.code.push(`    ${i==0 ? "add" : "adc"} rax, ${y(i)}`);
+            c.code.push(`    mov ${L(S, i)}, rax`);
+        }
+    }
+
+    // X = X op y over the 2*n64 words
+    function wide(op, X, y) {
+        for (let i=0; i<2*n64; i++) {
+            c.code.push(`    mov rax, ${L(X, i)}`);
+            c.code.push(`    ${i==0 ? op : (op == "add" ? "adc" : "sbb")} rax, ${y(i)}`);
+            c.code.push(`    mov ${L(X, i)}, rax`);
+        }
+    }
+
+    c.op("mov", "rcx", square ? "rsi" : "rdx");
+
+    let max0, max1;
+    if (square && nr == -1) {
+        c.code.push("; sa = a0 + a1, sb = a0 + q - a1");
+        sum(SA, (i) => A(0, i), (i) => A(1, i));
+        sum(SB, (i) => A(0, i), (i) => `[q + ${i*8}]`);
+        for (let i=0; i<n64; i++) {
+            c.code.push(`    mov rax, ${L(SB, i)}`);
+            c.code.push(`    ${i==0 ? "sub" : "sbb"} rax, ${A(1, i)}`);
+            c.code.push(`    mov ${L(SB, i)}, rax`);
+        }
+        mulSchoolbook(c, t, (i) => L(Z0, i), (i) => L(SA, i), (j) => L(SB, j), n64, n64);
+        c.code.push("; sa = 2*a0");
+        sum(SA, (i) => A(0, i), (i) => A(0, i));
+        mulSchoolbook(c, t, (i) => L(M, i), (i) => L(SA, i), (j) => A(1, j), n64, n64);
+        max0 = q1.multiply(2).multiply(q1.multiply(2));
+        max1 = q1.square().multiply(2);
+    } else {
+        mulSchoolbook(c, t, (i) => L(Z0, i), (i) => A(0, i), (j) => B(0, j), n64, n64);
+        mulSchoolbook(c, t, (i) => L(Z2, i), (i) => A(1, i), (j) => B(1, j), n64, n64);
+        c.code.push("; sa = a0 + a1, sb = b0 + b1");
+        sum(SA, (i) => A(0, i), (i) => A(1, i));
+        sum(SB, (i) => B(0, i), (i) => B(1, i));
+        mulSchoolbook(c, t, (i) => L(M, i), (i) => L(SA, i), (j) => L(SB, j), n64, n64);
+        c.code.push("; m = sa*sb - z0 - z2");
+        wide("sub", M, (i) => L(Z0, i));
+        wide("sub", M, (i) => L(Z2, i));
+        if (absNr > 1) {
+            c.code.push("; z2 = |nr|*z2");
+            c.op("xor", t, t);
+            c.code.push(`    mov rdx, ${absNr}`);
+            for (let i=0; i<2*n64; i++) {
+                c.op("mulx", 1, 0, L(Z2, i));
+                c.op("add", 0, t);
+                c.op("mov", L(Z2, i), 0);
+                c.op("mov", t, 1);
+                c.op("adc", t, "0");
+            }
+        }
+        if (nr < 0) {
+            c.code.push("; z0 = z0 + |nr|*q^2 - z2");
+            wide("add", Z0, (i) => `[f2NrQ2 + ${i*8}]`);
+            wide("sub", Z0, (i) => L(Z2, i));
+            max0 = q1.square().add(q.square().multiply(absNr));
+        } else {
+            c.code.push("; z0 = z0 + nr*z2");
+            wide("add", Z0, (i) => L(Z2, i));
+            max0 = q1.square().multiply(1 + absNr);
+        }
+        max1 = q1.square().multiply(2);
+    }
+
+    // The inputs are read before the result is written, so r can be a or b
+    reduceWide(c, fn + "_r0", t, n64, (i) => L(Z0, i), wideReductions(q, n64, max0));
+    for (let i=0; i<n64; i++) {
+        c.op("mov" ,  `[rdi + ${i*8}]`, t+i);
+    }
+    reduceWide(c, fn + "_r1", t, n64, (i) => L(M, i), wideReductions(q, n64, max1));
+    for (let i=0; i<n64; i++) {
+        c.op("mov" ,  `[rdi + ${(n64+i)*8}]`, t+i);
+    }
+
+    return c.getCode();
+}
+
+function buildF2Mul(fn, q, nr) {
+    return templateF2(fn, q, nr, false);
+}
+
+function buildF2Square(fn, q, nr) {
+    return templateF2(fn, q, nr, true);
 }
 
 
@@ -312,6 +888,15 @@ function buildFromMontgomery(fn, q) {
 }
 
 
+// Loops and fused tails, shared with specialbuilder.js
+module.exports.mulNLoop = mulNLoop;
+module.exports.squareNLoop = squareNLoop;
+module.exports.squarePow2Loop = squarePow2Loop;
+module.exports.mulAddFused = mulAddFused;
+module.exports.mulSubFused = mulSubFused;
+module.exports.mul2xStreams = mul2xStreams;
+module.exports.mul4xStreams = mul4xStreams;
+
 // const code = buildMontgomeryMul("Fr_rawMul", bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617"));
 // const code = buildMontgomeryMul("Fr_rawMul", bigInt("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F", 16));
 // const code = buildMontgomeryMul("Fr_rawMul", bigInt("4002409555221667393417789825735904156556882819939007885332058136124031650490837864442687629129015664037894272559787"));
@@ -0,0 +1,306 @@
+const bigInt = require("big-integer");
+const AsmBuilder = require("./asmbuilder");
+const montgomeryBuilder = require("./montgomerybuilder");
+
+// Multiplication kernels for special form primes.
+//
+// When c = 2^(64*n64) mod q fits in a word, the product Z = Zh*2^(64*n64) + Zl
+// can be reduced folding the high half: Z = Zh*c + Zl (mod q). This is the case
+// of the pseudo-Mersenne primes 2^k - c (2^255-19, the secp256k1 prime...) and of
+// the Goldilocks prime 2^64 - 2^32 + 1, that has its own reduction.
+//
+// There is no division by R in these kernels, so the elements of these fields are
+// kept in normal form (R = 1). The functions keep the names and the registers of
+// the Montgomery ones (montgomerybuilder.js) so the rest of the code does not
+// change: R2 and R3 are 1, rawToMontgomery and rawFromMontgomery are copies.
+
+module.exports.detect = detect;
+module.exports.buildMul = buildMul;
+module.exports.buildSquare = buildSquare;
+module.exports.buildMul1 = buildMul1;
+module.exports.buildFromMontgomery = buildFromMontgomery;
+module.exports.buildMulN = buildMulN;
+module.exports.buildMul2x = buildMul2x;
+module.exports.buildMul4x = buildMul4x;
+module.exports.buildSquareN = buildSquareN;
+module.exports.buildSquarePow2 = buildSquarePow2;
+module.exports.buildMulAdd = buildMulAdd;
+module.exports.buildMulSub = buildMulSub;
+module.exports.buildMulAddMul = buildMulAddMul;
+module.exports.buildMulSubMul = buildMulSubMul;
+
+const goldilocks = bigInt("FFFFFFFF00000001", 16);
+
+// Returns {form, c} for the primes with a special reduction and null for the
+// rest. form is "goldilocks" or "pseudoMersenne".
+function detect(q) {
+    q = bigInt(q);
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    if (q.eq(goldilocks)) return {form: "goldilocks", c: bigInt("FFFFFFFF", 16)};
+    // With one or two words the folds are not shorter than the Montgomery
+    // reduction and the chain of carries makes them slower.
+    if (n64 < 3) return null;
+    // q must use the top word, so a few substractions are enough at the end
+    if (q.bitLength() < n64*64 - 1) return null;
+    const c = bigInt.one.shiftLeft(n64*64).mod(q);
+    if (c.lt(bigInt.one.shiftLeft(64))) return {form: "pseudoMersenne", c};
+    return null;
+}
+
+function hex(v) {
+    return "0x" + v.toString(16);
+}
+
+// Reduces the 2*n64 words product in the locals from Z to t..t+n64-1, < q
+function reducePseudoMersenne(c, fn, params, Z) {
+    const {q, n64, t, special} = params;
+    const L = (i) => c.local(Z+i);
+
+    c.code.push("; Fold the high half: Zl + Zh*c");
+    c.op("mov", "rdx", hex(special.c));
+    for (let j=0; j<n64; j++) {
+        c.op("mov", t+j, L(j));
+    }
+    c.op("xor", 3, 3);
+    c.op("mov", t+n64, 3);
+    for (let j=0; j<n64; j++) {
+        c.op("mulx", 1, 0, L(n64+j));
+        c.op("adcx", t+j, 0);
+        c.op("adox", t+j+1, 1);
+    }
+    c.op("adcx", t+n64, 3);
+
+    c.code.push("; Fold the top word (<= c)");
+    c.op("mulx", 1, 0, t+n64);
+    c.op("add", t, 0);
+    c.op("adc", t+1, 1);
+    for (let j=2; j<n64; j++) c.op("adc", t+j, "0");
+
+    c.code.push("; Fold the carry. c^2 + c < 2^(64*n64), so it does not carry again");
+    c.op("sbb", 0, 0);
+    c.op("and", 0, "rdx");
+    c.op("add", t, 0);
+    for (let j=1; j<n64; j++) c.op("adc", t+j, "0");
+
+    const nReductions = bigInt.one.shiftLeft(n64*64).minus(1).divide(q).toJSNumber();
+    montgomeryBuilder.finalReduction(c, fn, t, n64, -1, nReductions);
+}
+
+// Reduces the product in (t+1:t) to t, < q. With EPS = 2^32-1 = 2^64 mod q and
+// Zh = (h1:h0) in 32 bit halves: Z = Zl - h1 + h0*EPS (mod q)
+function reduceGoldilocks(c, fn, params) {
+    const {t} = params;
+    c.code.push("; Zl - h1");
+    c.op("mov", 0, t+1);
+    c.op("shr", 0, "32");
+    c.op("mov", 1, t+1);
+    c.op("shl", 1, "32");
+    c.op("mov", 2, 1);
+    c.op("shr", 2, "32");
+    c.op("sub", 1, 2);
+    c.op("sub", t, 0);
+    c.code.push("; A borrow is 2^64 = EPS. The result does not borrow again");
+    c.op("sbb", 0, 0);
+    c.op("shr", 0, "32");
+    c.op("sub", t, 0);
+    c.code.push("; + h0*EPS. A carry is EPS again, that does not carry");
+    c.op("add", t, 1);
+    c.op("sbb", 0, 0);
+    c.op("shr", 0, "32");
+    c.op("add", t, 0);
+    c.code.push("; Substract q if t >= q, that is if t + EPS carries");
+    c.op("mov", 0, t);
+    c.op("mov", 1, "0xFFFFFFFF");
+    c.op("add", 0, 1);
+    c.op("cmovc", t, 0);
+}
+
+// t..t+n64-1 = a*b mod q. a and b are index to operand functions and a has na words
+function mulReduce(c, fn, params, Z, a, b, na) {
+    const {n64, t, special} = params;
+    if (special.form == "goldilocks") {
+        c.op("xor", 3, 3);
+        c.op("mov", "rdx", a(0));
+        c.op("mulx", t+1, t, b(0));
+        reduceGoldilocks(c, fn, params);
+    } else {
+        na = na || n64;
+        montgomeryBuilder.mulSchoolbook(c, t, (i) => c.local(Z+i), a, b, na, n64);
+        for (let i=na+n64; i<2*n64; i++) c.op("mov", c.local(Z+i), 3);
+        reducePseudoMersenne(c, fn, params, Z);
+    }
+}
+
+// Same loops, fused tails and streams as templateMontgomery. The fused tails get
+// the product reduced (< q) in t and t+n64 free, so a last substraction is enough.
+function templateSpecial(fn, q, square, loop, fused, streams) {
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    const special = detect(q);
+    const t = 4;
+    const params = {q, n64, t, special, canOptimizeConsensys: true};
+
+    const Z = (loop ? 4 : 0) + (fused ? fused.nLocals : 0) + (streams ? streams.nLocals : 0);
+    const c = new AsmBuilder(fn, 4 + n64 + 1, Z + 2*n64);
+
+    if (loop) {
+        loop.setup(c);
+        c.code.push(`    cmp ${c.local(0)}, 0`);
+        c.code.push(`    je ${fn}_end`);
+        c.code.push(fn+ "_loop:");
+    } else if (streams) {
+        streams.setup(c);
+    } else {
+        if (fused) fused.setup(c, params);
+        c.op("mov","rcx","rdx");
+    }
+
+    const ptrB = square ? "rsi" : "rcx";
+    const nStreams = streams ? streams.n : 1;
+    for (let k=0; k<nStreams; k++) {
+        const sfn = streams ? `${fn}_${k}` : fn;
+        if (streams) {
+            c.flushWr(true);
+            streams.select(c, k);
+        }
+        mulReduce(c, sfn, params, Z, (i) => `[rsi + ${i*8}]`, (j) => `[${ptrB} + ${j*8}]`);
+
+        if (fused) {
+            fused.tail(c, params);
+            montgomeryBuilder.finalReduction(c, fn+"_fused", t, n64, t+n64, 1);
+            fused.restore(c);
+        }
+        for (let i=0; i<n64; i++) {
+            c.op("mov" ,  `[rdi + ${i*8}]`, t+i);
+        }
+    }
+
+    if (loop) {
+        c.flushWr(true);
+        loop.next(c);
+        c.code.push(`    dec ${c.local(0)}`);
+        c.code.push(`    jnz ${fn}_loop`);
+        c.code.push(fn+ "_end:");
+    }
+
+    return c.getCode();
+}
+
+function buildMul(fn, q) {
+    return templateSpecial(fn, q, false);
+}
+
+function buildSquare(fn, q) {
+    return templateSpecial(fn, q, true);
+}
+
+function buildMulN(fn, q) {
+    return templateSpecial(fn, q, false, montgomeryBuilder.mulNLoop);
+}
+
+function buildMul2x(fn, q) {
+    return templateSpecial(fn, q, false, undefined, undefined, montgomeryBuilder.mul2xStreams);
+}
+
+function buildMul4x(fn, q) {
+    return templateSpecial(fn, q, false, undefined, undefined, montgomeryBuilder.mul4xStreams);
+}
+
+function buildSquareN(fn, q) {
+    return templateSpecial(fn, q, true, montgomeryBuilder.squareNLoop);
+}
+
+function buildSquarePow2(fn, q) {
+    return templateSpecial(fn, q, true, montgomeryBuilder.squarePow2Loop);
+}
+
+function buildMulAdd(fn, q) {
+    return templateSpecial(fn, q, false, undefined, montgomeryBuilder.mulAddFused);
+}
+
+function buildMulSub(fn, q) {
+    return templateSpecial(fn, q, false, undefined, montgomeryBuilder.mulSubFused);
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b, rcx <= c, r8 <= d.  r = a*b + c*d or a*b - c*d
+// a*b is reduced and kept in the locals from P, then c*d is reduced and added
+// (or substracted) with a last substraction.
+function templateMulAddMul(fn, q, sub) {
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    const special = detect(q);
+    const t = 4;
+    const params = {q, n64, t, special};
+
+    const P = 2, Z = P + n64;
+    const c = new AsmBuilder(fn, 4 + n64 + 1, Z + 2*n64);
+
+    c.code.push(`    mov ${c.local(0)}, rcx`);
+    c.code.push(`    mov ${c.local(1)}, r8`);
+    c.op("mov", "rcx", "rdx");
+    mulReduce(c, fn+"_ab", params, Z, (i) => `[rsi + ${i*8}]`, (j) => `[rcx + ${j*8}]`);
+    for (let i=0; i<n64; i++) {
+        c.op("mov", c.local(P+i), t+i);
+    }
+
+    c.code.push(`    mov rsi, ${c.local(0)}`);
+    c.code.push(`    mov rcx, ${c.local(1)}`);
+    mulReduce(c, fn+"_cd", params, Z, (i) => `[rsi + ${i*8}]`, (j) => `[rcx + ${j*8}]`);
+
+    if (sub) {
+        c.code.push("; q - c*d");
+        for (let i=0; i<n64; i++) {
+            c.op("mov", 0, `[q + ${i*8}]`);
+            c.op(i==0 ? "sub" : "sbb", 0, t+i);
+            c.op("mov", t+i, 0);
+        }
+    }
+    c.code.push("; Add a*b");
+    c.op("mov", t+n64, "0");
+    for (let i=0; i<n64; i++) {
+        c.op(i==0 ? "add" : "adc", t+i, c.local(P+i));
+    }
+    c.op("adc", t+n64, "0");
+    montgomeryBuilder.finalReduction(c, fn, t, n64, t+n64, 1);
+
+    for (let i=0; i<n64; i++) {
+        c.op("mov" ,  `[rdi + ${i*8}]`, t+i);
+    }
+
+    return c.getCode();
+}
+
+function buildMulAddMul(fn, q) {
+    return templateMulAddMul(fn, q, false);
+}
+
+function buildMulSubMul(fn, q) {
+    return templateMulAddMul(fn, q, true);
+}
+
+// Params: rdi <= r, rsi <= a, rdx <= b (a word). The word product is reduced as a
+// full one with the high words at 0.
+function buildMul1(fn, q) {
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    const special = detect(q);
+    const t = 4;
+    const params = {q, n64, t, special};
+
+    const c = new AsmBuilder(fn, 4 + n64 + 1, 2*n64);
+    c.op("mov", "rcx", "rdx");
+    mulReduce(c, fn, params, 0, () => "rcx", (j) => `[rsi + ${j*8}]`, 1);
+    for (let i=0; i<n64; i++) {
+        c.op("mov" ,  `[rdi + ${i*8}]`, t+i);
+    }
+
+    return c.getCode();
+}
+
+// The elements are already in normal form
+function buildFromMontgomery(fn, q) {
+    const n64 = Math.floor((q.bitLength() - 1) / 64)+1;
+    const c = new AsmBuilder(fn, 1, 0);
+    for (let i=0; i<n64; i++) {
+        c.op("mov", 0, `[rsi + ${i*8}]`);
+        c.op("mov", `[rdi + ${i*8}]`, 0);
+    }
+    return c.getCode();
+}
@@ -17,7 +17,7 @@ function compileGoogleTest() {
 }
 
 function createFieldSources() {
-    sh("node ../src/buildzqfield.js -q 21888242871839275222246405745257275088696311157297823662689037894645226208583 -n Fq", {cwd: "build"});
+    sh("node ../src/buildzqfield.js -q 21888242871839275222246405745257275088696311157297823662689037894645226208583 -n Fq --nr=-1", {cwd: "build"});
     sh("node ../src/buildzqfield.js -q 21888242871839275222246405745257275088548364400416034343698204186575808495617 -n Fr", {cwd: "build"});
     
     if (process.platform === "darwin") {
@@ -33,6 +33,11 @@ function createFieldSources() {
     } else throw("Unsupported platform");
 }
 
+function createFieldSourcesCpp() {
+    sh("node ../src/buildzqfield.js -q 21888242871839275222246405745257275088696311157297823662689037894645226208583 -n Fq --target=cpp --nr=-1", {cwd: "build"});
+    sh("node ../src/buildzqfield.js -q 21888242871839275222246405745257275088548364400416034343698204186575808495617 -n Fr --target=cpp", {cwd: "build"});
+}
+
 function testSplitParStr() {
     sh("g++" +
         " -Igoogletest-release-1.10.0/googletest/include"+
@@ -67,6 +72,25 @@ function testAltBn128() {
     sh("./altbn128_test", {cwd: "build", nopipe: true});
 }
 
+function testAltBn128Cpp() {
+    sh("g++" +
+        " -Igoogletest-release-1.10.0/googletest/include"+
+        " -I."+
+        " -I../c"+
+        " ../c/naf.cpp"+
+        " ../c/splitparstr.cpp"+
+        " ../c/alt_bn128.cpp"+
+        " ../c/alt_bn128_test.cpp"+
+        " ../c/misc.cpp"+
+        " fq.cpp"+
+        " fr.cpp"+
+        " googletest-release-1.10.0/libgtest.a"+
+        " -o altbn128_test" +
+        " -fmax-errors=5 -pthread -std=c++11 -fopenmp -lgmp -g", {cwd: "build", nopipe: true}
+    );
+    sh("./altbn128_test", {cwd: "build", nopipe: true});
+}
+
 function buildCurveAdds() {
     sh("g++ -O3 -g" +
         " -Igoogletest-release-1.10.0/googletest/include"+
@@ -156,17 +180,59 @@ function benchMultiExpG2() {
     sh("./multiexp_g2_benchmark 1000000", {cwd: "build", nopipe: true});
 }
 
+function benchFixedBase() {
+    sh("g++ -O3" +
+        " -I."+
+        " -I../c"+
+        " ../c/naf.cpp"+
+        " ../c/splitparstr.cpp"+
+        " ../c/alt_bn128.cpp"+
+        " ../c/misc.cpp"+
+        " ../benchmark/fixed_base.cpp"+
+        " fq.cpp"+
+        " fq.o"+
+        " fr.cpp"+
+        " fr.o"+
+        " -o fixed_base_benchmark" +
+        " -lgmp -pthread -std=c++11 -fopenmp" , {cwd: "build", nopipe: true}
+    );
+    sh("./fixed_base_benchmark 100000", {cwd: "build", nopipe: true});
+}
+
+function benchBatchMul() {
+    sh("g++ -O3" +
+        " -I."+
+        " -I../c"+
+        " ../c/naf.cpp"+
+        " ../c/splitparstr.cpp"+
+        " ../c/alt_bn128.cpp"+
+        " ../c/misc.cpp"+
+        " ../benchmark/batch_mul.cpp"+
+        " fq.cpp"+
+        " fq.o"+
+        " fr.cpp"+
+        " fr.o"+
+        " -o batch_mul_benchmark" +
+        " -lgmp -pthread -std=c++11 -fopenmp" , {cwd: "build", nopipe: true}
+    );
+    sh("./batch_mul_benchmark 100000", {cwd: "build", nopipe: true});
+}
+
 cli({
     cleanAll,
     downloadGoogleTest,
     compileGoogleTest,
     createFieldSources,
+    createFieldSourcesCpp,
     testSplitParStr,
     testAltBn128,
+    testAltBn128Cpp,
     buildBatchAccumulators,
     testBatchAccumulators,
     benchCurveAdds,
     buildCurveAdds,
     benchMultiExpG1,
     benchMultiExpG2,
+    benchFixedBase,
+    benchBatchMul,
 });
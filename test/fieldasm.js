@@ -3,12 +3,15 @@ const tester = require("./tester/buildzqfieldtester.js");
 const ZqField = require("ffjavascript").ZqField;
 
 const bigInt = require("big-integer");
+const specialBuilder = require("../src/specialbuilder.js");
 
 const bn128q = new bigInt("21888242871839275222246405745257275088696311157297823662689037894645226208583");
 const bn128r = new bigInt("21888242871839275222246405745257275088548364400416034343698204186575808495617");
 const bls12_381q = new bigInt("4002409555221667393417789825735904156556882819939007885332058136124031650490837864442687629129015664037894272559787");
 const secp256k1q = new bigInt("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEFFFFFC2F", 16);
 const secp256k1r = new bigInt("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFEBAAEDCE6AF48A03BBFD25E8CD0364141", 16);
+const goldilocks = new bigInt("FFFFFFFF00000001", 16);
+const p25519 = bigInt.one.shiftLeft(255).minus(19);
 const mnt6753q = new bigInt("41898490967918953402344214791240637128170709919953949071783502921025352812571106773058893763790338921418070971888458477323173057491593855069696241854796396165721416325350064441470418137846398469611935719059908164220784476160001");
 const mnt6753r = new bigInt("41898490967918953402344214791240637128170709919953949071783502921025352812571106773058893763790338921418070971888253786114353726529584385201591605722013126468931404347949840543007986327743462853720628051692141265303114721689601");
 
@@ -265,6 +268,30 @@ describe("field asm test", function () {
         const tv = buildTestVector1(secp256k1q, "inv");
         await tester(secp256k1q, tv);
     });
+    it("goldilocks mul", async () => {
+        const tv = buildTestVector2(goldilocks, "mul");
+        await tester(goldilocks, tv);
+    });
+    it("goldilocks square", async () => {
+        const tv = buildTestVector1(goldilocks, "square");
+        await tester(goldilocks, tv);
+    });
+    it("goldilocks inv", async () => {
+        const tv = buildTestVector1(goldilocks, "inv");
+        await tester(goldilocks, tv);
+    });
+    it("p25519 mul", async () => {
+        const tv = buildTestVector2(p25519, "mul");
+        await tester(p25519, tv);
+    });
+    it("p25519 square", async () => {
+        const tv = buildTestVector1(p25519, "square");
+        await tester(p25519, tv);
+    });
+    it("p25519 inv", async () => {
+        const tv = buildTestVector1(p25519, "inv");
+        await tester(p25519, tv);
+    });
     it("mnt6753q inv", async () => {
         const tv = buildTestVector1(mnt6753q, "inv");
         await tester(mnt6753q, tv);
@@ -452,7 +479,9 @@ function getCriticalNumbers(p, lim) {
             return S;
         }
 
+        // Special form primes keep the elements in normal form
         function toMontgomery(a) {
+            if (specialBuilder.detect(p)) return a;
             const n64 = Math.floor((p.bitLength() - 1) / 64)+1;
             const R = bigInt.one.shiftLeft(n64*64);
             return a.times(R).mod(p);